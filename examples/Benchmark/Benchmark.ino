@@ -0,0 +1,15 @@
+// Measures TinyConfig latency, file traffic and heap usage on the device.
+// WARNING: overwrites /config.json. Results are printed as JSON lines.
+
+#include <TinyConfig.h>
+#include "TinyConfigBench.h"
+
+void setup() {
+    Serial.begin(115200);
+    delay(2000);
+    runTinyConfigBench(Serial);
+}
+
+void loop() {
+    // Nothing to do
+}
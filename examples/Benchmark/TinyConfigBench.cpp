@@ -0,0 +1,473 @@
+// Licensed under Apache License, Version 2.0
+// SPDX-License-Identifier: Apache-2.0
+// http://www.apache.org/licenses/LICENSE-2.0
+// © 2025 Lennart Gutjahr
+
+#include "TinyConfigBench.h"
+#include <TinyConfig.h>
+#include <limits.h>
+#include <vector>
+
+#ifdef TINYCONFIG_HOST
+#include <HostHeap.h>
+#else
+// umm_malloc statistics of the ESP8266 core (enabled by default through UMM_STATS).
+extern "C" {
+size_t umm_free_heap_size_min_reset(void);
+size_t umm_free_heap_size_min(void);
+}
+#endif
+
+namespace {
+
+const unsigned keyCounts[] = {10, 50, 100, 200};
+const unsigned valueSizes[] = {0, 8, 32}; // 0 = int values, otherwise string length
+const size_t maxFileSize = 4096;
+
+#ifdef TINYCONFIG_HOST
+const char* const platformName = "host";
+size_t heapBase = 0;
+
+void heapReset() {
+    hostHeapResetPeak();
+    heapBase = hostHeapStats().inUse;
+}
+
+size_t heapPeak() {
+    return hostHeapStats().peak - heapBase;
+}
+#else
+const char* const platformName = "esp8266";
+size_t heapBase = 0;
+
+void heapReset() {
+    heapBase = umm_free_heap_size_min_reset();
+}
+
+size_t heapPeak() {
+    return heapBase - umm_free_heap_size_min();
+}
+#endif
+
+struct Sample {
+    unsigned long total = 0;
+    unsigned long min = ULONG_MAX;
+    unsigned long max = 0;
+    unsigned count = 0;
+    unsigned long bytesRead = 0;
+    unsigned long bytesWritten = 0;
+    uint32_t parsedBefore = 0;
+    uint32_t serializedBefore = 0;
+    unsigned long start = 0;
+
+    // Starts a timed call; file traffic is taken from the TinyConfig stats.
+    void begin(const TinyConfig& tc) {
+        parsedBefore = tc.getStats().bytesParsed;
+        serializedBefore = tc.getStats().bytesSerialized;
+        start = micros();
+    }
+
+    void end(const TinyConfig& tc) {
+        unsigned long us = micros() - start;
+        total += us;
+        if (us < min) min = us;
+        if (us > max) max = us;
+        count++;
+        bytesRead += tc.getStats().bytesParsed - parsedBefore;
+        bytesWritten += tc.getStats().bytesSerialized - serializedBefore;
+    }
+};
+
+struct Case {
+    const char* mode;
+    unsigned keys;
+    unsigned valueSize;
+    unsigned requestedKeys; // set when keys was cut down to what fits maxFileSize
+};
+
+// Discards everything, so getAll(Print&) is measured without the cost of a sink.
+class NullPrint : public Print {
+public:
+    size_t write(uint8_t) override { return 1; }
+    size_t write(const uint8_t*, size_t size) override { return size; }
+};
+
+const char* configFileName(TinyConfigFormat format) {
+    switch (format) {
+        case TinyConfigFormat::MessagePack:
+            return "/config.msgpack";
+        case TinyConfigFormat::Indexed:
+            return "/config.idx";
+        default:
+            return "/config.json";
+    }
+}
+
+size_t configFileSize(const TinyConfig& tc) {
+    File f = LittleFS.open(configFileName(tc.getFormat()), "r");
+    size_t size = f ? f.size() : 0;
+    f.close();
+    return size;
+}
+
+String makeValue(unsigned size) {
+    String value;
+    value.reserve(size);
+    for (unsigned i = 0; i < size; ++i) {
+        value += static_cast<char>('a' + i % 26);
+    }
+    return value;
+}
+
+bool setValue(TinyConfig& tc, const String& key, unsigned valueSize, const String& text, int number) {
+    return valueSize == 0 ? tc.set(key, number) : tc.set(key, text);
+}
+
+void report(Print& out, const Case& c, const char* op, const Sample& sample, size_t fileBytes, size_t peakHeap) {
+    StaticJsonDocument<512> row;
+    row["platform"] = platformName;
+    row["mode"] = c.mode;
+    row["op"] = op;
+    row["keys"] = c.keys;
+    row["value_size"] = c.valueSize;
+    if (c.requestedKeys) {
+        row["requested_keys"] = c.requestedKeys;
+    }
+    row["file_bytes"] = static_cast<unsigned long>(fileBytes);
+    row["iterations"] = sample.count;
+    row["us_mean"] = sample.count ? sample.total / sample.count : 0;
+    row["us_min"] = sample.count ? sample.min : 0;
+    row["us_max"] = sample.max;
+    row["bytes_read"] = sample.count ? sample.bytesRead / sample.count : 0;
+    row["bytes_written"] = sample.count ? sample.bytesWritten / sample.count : 0;
+    row["peak_heap"] = static_cast<unsigned long>(peakHeap);
+    serializeJson(row, out);
+    out.println();
+}
+
+void reportError(Print& out, const Case& c, TinyConfig& tc) {
+    StaticJsonDocument<256> row;
+    row["platform"] = platformName;
+    row["mode"] = c.mode;
+    row["keys"] = c.keys;
+    row["value_size"] = c.valueSize;
+    row["error"] = tc.getLastErrorString();
+    serializeJson(row, out);
+    out.println();
+}
+
+// Short keys, so that more of them fit into maxFileSize.
+std::vector<String> makeKeys(unsigned count) {
+    std::vector<String> keys;
+    keys.reserve(count);
+    for (unsigned i = 0; i < count; ++i) {
+        String key = "k";
+        key += i;
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+bool populate(TinyConfig& tc, const std::vector<String>& keys, unsigned valueSize) {
+    if (!tc.resetConfig()) {
+        return false;
+    }
+    String text = makeValue(valueSize);
+    TinyConfig::Transaction tx = tc.beginTransaction();
+    for (unsigned i = 0; i < keys.size(); ++i) {
+        bool ok = valueSize == 0 ? tx.set(keys[i], static_cast<int>(i)) : tx.set(keys[i], text);
+        if (!ok) {
+            return false;
+        }
+    }
+    return tx.commit();
+}
+
+// The largest number of keys up to wanted whose configuration fits maxFileSize, 0 if not even one does.
+unsigned fittingKeyCount(TinyConfig& tc, unsigned wanted, unsigned valueSize) {
+    if (populate(tc, makeKeys(wanted), valueSize)) {
+        return wanted;
+    }
+    unsigned fits = 0;
+    unsigned fails = wanted;
+    while (fails - fits > 1) {
+        unsigned middle = fits + (fails - fits) / 2;
+        if (populate(tc, makeKeys(middle), valueSize)) {
+            fits = middle;
+        } else {
+            fails = middle;
+        }
+    }
+    return fits;
+}
+
+void applyMode(TinyConfig& tc, const char* mode) {
+    tc.setCacheMode(strcmp(mode, "cache") == 0);
+    tc.setLogMode(strcmp(mode, "log") == 0);
+    if (strcmp(mode, "msgpack") == 0) {
+        tc.setFormat(TinyConfigFormat::MessagePack);
+    } else if (strcmp(mode, "indexed") == 0) {
+        tc.setFormat(TinyConfigFormat::Indexed);
+    } else {
+        tc.setFormat(TinyConfigFormat::Json);
+    }
+}
+
+// Bytes read/written are the mean per call, measured with TinyConfig::getStats().
+void runCase(Print& out, TinyConfig& tc, const Case& c, unsigned iterations) {
+    applyMode(tc, c.mode);
+
+    std::vector<String> keys = makeKeys(c.keys);
+    if (!populate(tc, keys, c.valueSize)) {
+        reportError(out, c, tc);
+        return;
+    }
+    String text = makeValue(c.valueSize);
+    size_t fileBytes = configFileSize(tc);
+
+    Sample get;
+    heapReset();
+    for (unsigned i = 0; i < iterations; ++i) {
+        const String& key = keys[i % c.keys];
+        get.begin(tc);
+        if (c.valueSize == 0) {
+            volatile int value = tc.getInt(key, -1);
+            (void)value;
+        } else {
+            String value = tc.getString(key, "");
+        }
+        get.end(tc);
+    }
+    report(out, c, c.valueSize == 0 ? "getInt" : "getString", get, fileBytes, heapPeak());
+
+    Sample ref;
+    TinyConfigRef<int> number = tc.ref<int>(keys[0], -1);
+    TinyConfigRef<String> word = tc.ref<String>(keys[0], "");
+    heapReset();
+    for (unsigned i = 0; i < iterations; ++i) {
+        ref.begin(tc);
+        if (c.valueSize == 0) {
+            volatile int value = number.get();
+            (void)value;
+        } else {
+            String value = word.get();
+        }
+        ref.end(tc);
+    }
+    report(out, c, "getRef", ref, fileBytes, heapPeak());
+
+    Sample set;
+    heapReset();
+    for (unsigned i = 0; i < iterations; ++i) {
+        const String& key = keys[i % c.keys];
+        set.begin(tc);
+        setValue(tc, key, c.valueSize, text, static_cast<int>(i % c.keys));
+        set.end(tc);
+    }
+    report(out, c, "set", set, fileBytes, heapPeak());
+
+    Sample del;
+    heapReset();
+    for (unsigned i = 0; i < iterations; ++i) {
+        std::vector<String> victims(1, keys[i % c.keys]);
+        del.begin(tc);
+        tc.deleteKeys(victims);
+        del.end(tc);
+        setValue(tc, victims[0], c.valueSize, text, static_cast<int>(i % c.keys));
+    }
+    report(out, c, "deleteKeys", del, fileBytes, heapPeak());
+
+    Sample all;
+    heapReset();
+    for (unsigned i = 0; i < iterations; ++i) {
+        all.begin(tc);
+        String json = tc.getAll();
+        all.end(tc);
+    }
+    report(out, c, "getAll", all, fileBytes, heapPeak());
+
+    Sample stream;
+    NullPrint sink;
+    heapReset();
+    for (unsigned i = 0; i < iterations; ++i) {
+        stream.begin(tc);
+        tc.getAll(sink);
+        stream.end(tc);
+    }
+    report(out, c, "getAllStream", stream, fileBytes, heapPeak());
+}
+
+// Reads one member the way a getter did before filtered gets: the whole file is parsed into a maxFileSize document.
+void runFullParse(Sample& sample, TinyConfig& tc, const char* key, unsigned iterations) {
+    for (unsigned i = 0; i < iterations; ++i) {
+        sample.begin(tc);
+        File f = LittleFS.open(configFileName(tc.getFormat()), "r");
+        DynamicJsonDocument doc(maxFileSize);
+        deserializeJson(doc, f);
+        volatile size_t found = doc[key].isNull() ? 0 : 1;
+        (void)found;
+        size_t size = f.size();
+        f.close();
+        sample.end(tc);
+        sample.bytesRead += size;
+    }
+}
+
+// A single getInt and getString next to large string values, in the largest file a 4096 byte document can still
+// parse completely. The fullParse rows are the baseline without filtering.
+void runSingleKeyCase(Print& out, TinyConfig& tc, unsigned iterations) {
+    tc.setCacheMode(false);
+    tc.setLogMode(false);
+    tc.setFormat(TinyConfigFormat::Json);
+
+    const unsigned stringKeys = 26;
+    Case c = {"file", stringKeys + 1, 96, 0};
+    if (!tc.resetConfig()) {
+        reportError(out, c, tc);
+        return;
+    }
+    String text = makeValue(c.valueSize);
+    TinyConfig::Transaction tx = tc.beginTransaction();
+    for (unsigned i = 0; i < stringKeys; ++i) {
+        String key = "key";
+        key += i;
+        tx.set(key, text);
+    }
+    tx.set("boot_count", 1);
+    if (!tx.commit()) {
+        reportError(out, c, tc);
+        return;
+    }
+    size_t fileBytes = configFileSize(tc);
+
+    Sample get;
+    heapReset();
+    for (unsigned i = 0; i < iterations; ++i) {
+        get.begin(tc);
+        volatile int value = tc.getInt("boot_count", -1);
+        (void)value;
+        get.end(tc);
+    }
+    report(out, c, "getIntSingleKey", get, fileBytes, heapPeak());
+
+    Sample full;
+    heapReset();
+    runFullParse(full, tc, "boot_count", iterations);
+    report(out, c, "getIntFullParse", full, fileBytes, heapPeak());
+
+    Sample textGet;
+    heapReset();
+    for (unsigned i = 0; i < iterations; ++i) {
+        textGet.begin(tc);
+        String value = tc.getString("key0", "");
+        textGet.end(tc);
+    }
+    report(out, c, "getStringSingleKey", textGet, fileBytes, heapPeak());
+
+    Sample textParse;
+    heapReset();
+    runFullParse(textParse, tc, "key0", iterations);
+    report(out, c, "getStringFullParse", textParse, fileBytes, heapPeak());
+}
+
+// Reading the settings at boot: 15 ints and 10 strings, one getter per key versus one getMany().
+void runBootCase(Print& out, TinyConfig& tc, unsigned iterations) {
+    tc.setCacheMode(false);
+    tc.setLogMode(false);
+    tc.setFormat(TinyConfigFormat::Json);
+
+    const unsigned intKeys = 15;
+    const unsigned stringKeys = 10;
+    Case c = {"file", intKeys + stringKeys, 16, 0};
+    std::vector<String> keys;
+    for (unsigned i = 0; i < intKeys + stringKeys; ++i) {
+        String key = i < intKeys ? "int" : "str";
+        key += i;
+        keys.push_back(key);
+    }
+    if (!tc.resetConfig()) {
+        reportError(out, c, tc);
+        return;
+    }
+    String text = makeValue(c.valueSize);
+    TinyConfig::Transaction tx = tc.beginTransaction();
+    for (unsigned i = 0; i < keys.size(); ++i) {
+        if (i < intKeys) {
+            tx.set(keys[i], static_cast<int>(i));
+        } else {
+            tx.set(keys[i], text);
+        }
+    }
+    if (!tx.commit()) {
+        reportError(out, c, tc);
+        return;
+    }
+    size_t fileBytes = configFileSize(tc);
+
+    int numbers[intKeys];
+    char strings[stringKeys][32];
+    Sample gets;
+    heapReset();
+    for (unsigned n = 0; n < iterations; ++n) {
+        gets.begin(tc);
+        for (unsigned i = 0; i < intKeys; ++i) {
+            numbers[i] = tc.getInt(keys[i], -1);
+        }
+        for (unsigned i = 0; i < stringKeys; ++i) {
+            tc.getString(keys[intKeys + i], strings[i], sizeof(strings[i]));
+        }
+        gets.end(tc);
+    }
+    report(out, c, "bootGets", gets, fileBytes, heapPeak());
+
+    std::vector<TinyConfigTarget> targets;
+    for (unsigned i = 0; i < intKeys; ++i) {
+        targets.push_back(TinyConfigTarget(keys[i].c_str(), &numbers[i], -1));
+    }
+    for (unsigned i = 0; i < stringKeys; ++i) {
+        targets.push_back(TinyConfigTarget(keys[intKeys + i].c_str(), strings[i], sizeof(strings[i])));
+    }
+    Sample many;
+    heapReset();
+    for (unsigned n = 0; n < iterations; ++n) {
+        many.begin(tc);
+        tc.getMany(targets.data(), targets.size());
+        many.end(tc);
+    }
+    report(out, c, "bootGetMany", many, fileBytes, heapPeak());
+}
+
+} // namespace
+
+void runTinyConfigBench(Print& out, unsigned iterations) {
+    TinyConfig tc;
+    tc.setMaxFileSize(maxFileSize);
+    if (!tc.StartTC()) {
+        out.println(tc.getLastErrorString());
+        return;
+    }
+    const char* const modes[] = {"file", "cache", "log", "msgpack", "indexed"};
+    for (const char* mode : modes) {
+        applyMode(tc, mode);
+        for (unsigned valueSize : valueSizes) {
+            // A key count that does not fit is cut down to the largest one that does, measured once.
+            unsigned measured = 0;
+            for (unsigned keys : keyCounts) {
+                unsigned fitting = fittingKeyCount(tc, keys, valueSize);
+                if (fitting <= measured) {
+                    continue;
+                }
+                Case c = {mode, fitting, valueSize, fitting < keys ? keys : 0};
+                runCase(out, tc, c, iterations);
+                measured = fitting;
+            }
+        }
+    }
+    runSingleKeyCase(out, tc, iterations);
+    runBootCase(out, tc, iterations);
+    tc.setCacheMode(false);
+    tc.setLogMode(false);
+    tc.setFormat(TinyConfigFormat::Json);
+    tc.resetConfig();
+    tc.StopTC();
+}
@@ -0,0 +1,20 @@
+// Licensed under Apache License, Version 2.0
+// SPDX-License-Identifier: Apache-2.0
+// http://www.apache.org/licenses/LICENSE-2.0
+// © 2025 Lennart Gutjahr
+
+#pragma once
+#include <Arduino.h>
+
+/**
+ * @brief Runs the TinyConfig benchmark matrix and prints the results.
+ * @param out Where to print the results, e.g. Serial.
+ * @param iterations Number of timed calls per operation and configuration.
+ *
+ * Every combination of key count, value size and mode (file, cache, log, msgpack, indexed) is measured for getInt/getString, a TinyConfigRef read, set, deleteKeys, getAll and getAll(Print&).
+ * A single-key getInt on the largest file a 4096 byte document can parse is measured separately.
+ * Reading 25 settings at boot is measured with one getter per key (bootGets) and with one getMany() (bootGetMany).
+ * Each result is printed as one JSON object per line, so runs of different releases can be compared with a script.
+ * The benchmark overwrites /config.json, /config.log, /config.msgpack and /config.idx.
+ */
+void runTinyConfigBench(Print& out, unsigned iterations = 20);
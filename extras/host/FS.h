@@ -0,0 +1,78 @@
+// Licensed under Apache License, Version 2.0
+// SPDX-License-Identifier: Apache-2.0
+// http://www.apache.org/licenses/LICENSE-2.0
+// © 2025 Lennart Gutjahr
+
+// Host stand-in for the ESP8266 FS/File API, backed by a POSIX directory.
+// Paths like "/config.json" map to "<root>/config.json", where <root> is
+// $TINYCONFIG_FS_ROOT or "./littlefs" if the variable is not set.
+
+#pragma once
+#include <cstdio>
+#include <memory>
+#include "Arduino.h"
+
+namespace fs {
+
+enum SeekMode {
+    SeekSet = 0,
+    SeekCur = 1,
+    SeekEnd = 2
+};
+
+class File : public Stream {
+public:
+    File() {}
+    File(std::FILE* handle, const String& name);
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t read(uint8_t* buffer, size_t size);
+    size_t readBytes(char* buffer, size_t length) override {
+        return read(reinterpret_cast<uint8_t*>(buffer), length);
+    }
+    void flush() override;
+
+    bool seek(uint32_t pos, SeekMode mode = SeekSet);
+    size_t position() const;
+    size_t size() const;
+    void close();
+    const char* name() const;
+    explicit operator bool() const { return static_cast<bool>(handle); }
+
+private:
+    std::shared_ptr<std::FILE> handle;
+    String fileName;
+};
+
+class FS {
+public:
+    bool begin();
+    void end();
+    bool format();
+    bool exists(const char* path);
+    bool exists(const String& path) { return exists(path.c_str()); }
+    File open(const char* path, const char* mode);
+    File open(const String& path, const char* mode) { return open(path.c_str(), mode); }
+    bool remove(const char* path);
+    bool remove(const String& path) { return remove(path.c_str()); }
+    bool rename(const char* pathFrom, const char* pathTo);
+    bool rename(const String& pathFrom, const String& pathTo) { return rename(pathFrom.c_str(), pathTo.c_str()); }
+
+private:
+    bool mounted = false;
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
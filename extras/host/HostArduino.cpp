@@ -0,0 +1,190 @@
+// Licensed under Apache License, Version 2.0
+// SPDX-License-Identifier: Apache-2.0
+// http://www.apache.org/licenses/LICENSE-2.0
+// © 2025 Lennart Gutjahr
+
+#include "Arduino.h"
+#include "LittleFS.h"
+
+#include <chrono>
+#include <thread>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+fs::FS LittleFS;
+HardwareSerial Serial;
+
+namespace {
+
+const auto startTime = std::chrono::steady_clock::now();
+
+// The CMake build defaults to <build dir>/littlefs, so runs do not write into the working directory.
+#ifndef TINYCONFIG_FS_DEFAULT_ROOT
+#define TINYCONFIG_FS_DEFAULT_ROOT "littlefs"
+#endif
+
+std::string rootDir() {
+    const char* root = std::getenv("TINYCONFIG_FS_ROOT");
+    return (root && *root) ? root : TINYCONFIG_FS_DEFAULT_ROOT;
+}
+
+std::string hostPath(const char* path) {
+    std::string result = rootDir();
+    if (path[0] != '/') result += '/';
+    return result + path;
+}
+
+const char* hostMode(const char* mode) {
+    if (strcmp(mode, "r") == 0) return "rb";
+    if (strcmp(mode, "w") == 0) return "wb";
+    if (strcmp(mode, "a") == 0) return "ab";
+    if (strcmp(mode, "r+") == 0) return "r+b";
+    if (strcmp(mode, "w+") == 0) return "w+b";
+    if (strcmp(mode, "a+") == 0) return "a+b";
+    return nullptr;
+}
+
+} // namespace
+
+unsigned long millis() {
+    return static_cast<unsigned long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - startTime).count());
+}
+
+unsigned long micros() {
+    return static_cast<unsigned long>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - startTime).count());
+}
+
+void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void yield() {}
+
+namespace fs {
+
+File::File(std::FILE* file, const String& name)
+    : handle(file, [](std::FILE* f) { std::fclose(f); }), fileName(name) {}
+
+size_t File::write(uint8_t c) {
+    if (!handle) return 0;
+    return std::fputc(c, handle.get()) == EOF ? 0 : 1;
+}
+
+size_t File::write(const uint8_t* buffer, size_t size) {
+    if (!handle) return 0;
+    return std::fwrite(buffer, 1, size, handle.get());
+}
+
+int File::available() {
+    if (!handle) return 0;
+    return static_cast<int>(size() - position());
+}
+
+int File::read() {
+    if (!handle) return -1;
+    int c = std::fgetc(handle.get());
+    return c == EOF ? -1 : c;
+}
+
+int File::peek() {
+    if (!handle) return -1;
+    int c = std::fgetc(handle.get());
+    if (c == EOF) return -1;
+    std::ungetc(c, handle.get());
+    return c;
+}
+
+size_t File::read(uint8_t* buffer, size_t size) {
+    if (!handle) return 0;
+    return std::fread(buffer, 1, size, handle.get());
+}
+
+void File::flush() {
+    if (handle) std::fflush(handle.get());
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+    if (!handle) return false;
+    int whence = mode == SeekCur ? SEEK_CUR : (mode == SeekEnd ? SEEK_END : SEEK_SET);
+    return std::fseek(handle.get(), static_cast<long>(pos), whence) == 0;
+}
+
+size_t File::position() const {
+    if (!handle) return 0;
+    long pos = std::ftell(handle.get());
+    return pos < 0 ? 0 : static_cast<size_t>(pos);
+}
+
+size_t File::size() const {
+    if (!handle) return 0;
+    std::fflush(handle.get());
+    struct stat st;
+    if (fstat(fileno(handle.get()), &st) != 0) return 0;
+    return static_cast<size_t>(st.st_size);
+}
+
+void File::close() {
+    handle.reset();
+}
+
+const char* File::name() const {
+    return fileName.c_str();
+}
+
+bool FS::begin() {
+    std::string root = rootDir();
+    struct stat st;
+    if (stat(root.c_str(), &st) != 0 && mkdir(root.c_str(), 0755) != 0) {
+        return false;
+    }
+    mounted = true;
+    return true;
+}
+
+void FS::end() {
+    mounted = false;
+}
+
+bool FS::format() {
+    std::string root = rootDir();
+    DIR* dir = opendir(root.c_str());
+    if (!dir) return true;
+    while (struct dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] == '.') continue;
+        std::string path = root;
+        path += '/';
+        path += entry->d_name;
+        std::remove(path.c_str());
+    }
+    closedir(dir);
+    return true;
+}
+
+bool FS::exists(const char* path) {
+    if (!mounted) return false;
+    struct stat st;
+    return stat(hostPath(path).c_str(), &st) == 0;
+}
+
+File FS::open(const char* path, const char* mode) {
+    const char* fmode = hostMode(mode);
+    if (!mounted || !fmode) return File();
+    std::FILE* f = std::fopen(hostPath(path).c_str(), fmode);
+    if (!f) return File();
+    return File(f, path);
+}
+
+bool FS::remove(const char* path) {
+    if (!mounted) return false;
+    return std::remove(hostPath(path).c_str()) == 0;
+}
+
+bool FS::rename(const char* pathFrom, const char* pathTo) {
+    if (!mounted) return false;
+    return std::rename(hostPath(pathFrom).c_str(), hostPath(pathTo).c_str()) == 0;
+}
+
+} // namespace fs
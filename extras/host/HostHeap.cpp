@@ -0,0 +1,89 @@
+// Licensed under Apache License, Version 2.0
+// SPDX-License-Identifier: Apache-2.0
+// http://www.apache.org/licenses/LICENSE-2.0
+// © 2025 Lennart Gutjahr
+
+// Counts heap usage by interposing the glibc allocator entry points.
+
+#include "HostHeap.h"
+
+#include <cerrno>
+#include <malloc.h>
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+}
+
+namespace {
+
+HostHeapStats stats = {0, 0, 0};
+
+void track(void* ptr) {
+    if (!ptr) return;
+    stats.allocations++;
+    stats.inUse += malloc_usable_size(ptr);
+    if (stats.inUse > stats.peak) stats.peak = stats.inUse;
+}
+
+void untrack(void* ptr) {
+    if (ptr) stats.inUse -= malloc_usable_size(ptr);
+}
+
+} // namespace
+
+HostHeapStats hostHeapStats() {
+    return stats;
+}
+
+void hostHeapResetPeak() {
+    stats.peak = stats.inUse;
+}
+
+extern "C" {
+
+void* malloc(size_t size) {
+    void* ptr = __libc_malloc(size);
+    track(ptr);
+    return ptr;
+}
+
+void* calloc(size_t count, size_t size) {
+    void* ptr = __libc_calloc(count, size);
+    track(ptr);
+    return ptr;
+}
+
+void* realloc(void* ptr, size_t size) {
+    untrack(ptr);
+    void* result = __libc_realloc(ptr, size);
+    track(result ? result : (size ? ptr : nullptr));
+    return result;
+}
+
+void free(void* ptr) {
+    untrack(ptr);
+    __libc_free(ptr);
+}
+
+void* memalign(size_t alignment, size_t size) {
+    void* ptr = __libc_memalign(alignment, size);
+    track(ptr);
+    return ptr;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    return memalign(alignment, size);
+}
+
+int posix_memalign(void** result, size_t alignment, size_t size) {
+    void* ptr = memalign(alignment, size);
+    if (!ptr) return ENOMEM;
+    *result = ptr;
+    return 0;
+}
+
+} // extern "C"
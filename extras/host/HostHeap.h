@@ -0,0 +1,19 @@
+// Licensed under Apache License, Version 2.0
+// SPDX-License-Identifier: Apache-2.0
+// http://www.apache.org/licenses/LICENSE-2.0
+// © 2025 Lennart Gutjahr
+
+// Heap accounting for the host build. Every malloc/free of the process
+// (including operator new and ArduinoJson's pool) goes through these counters.
+
+#pragma once
+#include <cstddef>
+
+struct HostHeapStats {
+    size_t allocations; // number of successful allocations so far
+    size_t inUse;       // bytes currently allocated
+    size_t peak;        // highest inUse since the last hostHeapResetPeak()
+};
+
+HostHeapStats hostHeapStats();
+void hostHeapResetPeak();
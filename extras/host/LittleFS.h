@@ -0,0 +1,11 @@
+// Licensed under Apache License, Version 2.0
+// SPDX-License-Identifier: Apache-2.0
+// http://www.apache.org/licenses/LICENSE-2.0
+// © 2025 Lennart Gutjahr
+
+// Host stand-in for the ESP8266 LittleFS global.
+
+#pragma once
+#include "FS.h"
+
+extern fs::FS LittleFS;
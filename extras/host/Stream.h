@@ -0,0 +1,36 @@
+// Licensed under Apache License, Version 2.0
+// SPDX-License-Identifier: Apache-2.0
+// http://www.apache.org/licenses/LICENSE-2.0
+// © 2025 Lennart Gutjahr
+
+// Host stand-in for the Arduino Stream interface.
+
+#pragma once
+#include "Print.h"
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    virtual size_t readBytes(char* buffer, size_t length) {
+        size_t n = 0;
+        while (n < length) {
+            int c = read();
+            if (c < 0) break;
+            buffer[n++] = static_cast<char>(c);
+        }
+        return n;
+    }
+    size_t readBytes(uint8_t* buffer, size_t length) {
+        return readBytes(reinterpret_cast<char*>(buffer), length);
+    }
+    String readString() {
+        String result;
+        int c;
+        while ((c = read()) >= 0) result.concat(static_cast<char>(c));
+        return result;
+    }
+    void setTimeout(unsigned long timeout) { (void)timeout; }
+};
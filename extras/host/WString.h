@@ -0,0 +1,124 @@
+// Licensed under Apache License, Version 2.0
+// SPDX-License-Identifier: Apache-2.0
+// http://www.apache.org/licenses/LICENSE-2.0
+// © 2025 Lennart Gutjahr
+
+// Host stand-in for the Arduino String class, backed by std::string.
+
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+class String {
+public:
+    String() {}
+    String(const char* s) : str(s ? s : "") {}
+    String(const char* s, size_t n) : str(s, n) {}
+    String(const std::string& s) : str(s) {}
+    explicit String(char c) : str(1, c) {}
+    explicit String(int value, unsigned char base = 10) : str(fromLong(value, base)) {}
+    explicit String(unsigned int value, unsigned char base = 10) : str(fromULong(value, base)) {}
+    explicit String(long value, unsigned char base = 10) : str(fromLong(value, base)) {}
+    explicit String(unsigned long value, unsigned char base = 10) : str(fromULong(value, base)) {}
+    explicit String(float value, unsigned char decimals = 2) : str(fromDouble(value, decimals)) {}
+    explicit String(double value, unsigned char decimals = 2) : str(fromDouble(value, decimals)) {}
+
+    const char* c_str() const { return str.c_str(); }
+    unsigned int length() const { return static_cast<unsigned int>(str.size()); }
+    bool isEmpty() const { return str.empty(); }
+    bool reserve(unsigned int size) { str.reserve(size); return true; }
+
+    bool concat(const String& s) { str += s.str; return true; }
+    bool concat(const char* s) { if (s) str += s; return s != nullptr; }
+    bool concat(const char* s, unsigned int n) { if (s) str.append(s, n); return s != nullptr; }
+    bool concat(char c) { str += c; return true; }
+    bool concat(int v) { str += fromLong(v, 10); return true; }
+    bool concat(unsigned int v) { str += fromULong(v, 10); return true; }
+    bool concat(long v) { str += fromLong(v, 10); return true; }
+    bool concat(unsigned long v) { str += fromULong(v, 10); return true; }
+    bool concat(float v) { str += fromDouble(v, 2); return true; }
+    bool concat(double v) { str += fromDouble(v, 2); return true; }
+
+    template <typename T>
+    String& operator+=(const T& rhs) { concat(rhs); return *this; }
+
+    char operator[](unsigned int index) const { return index < str.size() ? str[index] : 0; }
+    char& operator[](unsigned int index) { return str[index]; }
+    char charAt(unsigned int index) const { return (*this)[index]; }
+
+    bool equals(const String& s) const { return str == s.str; }
+    bool equals(const char* s) const { return str == (s ? s : ""); }
+    bool operator==(const String& s) const { return equals(s); }
+    bool operator==(const char* s) const { return equals(s); }
+    bool operator!=(const String& s) const { return !equals(s); }
+    bool operator!=(const char* s) const { return !equals(s); }
+    bool operator<(const String& s) const { return str < s.str; }
+    int compareTo(const String& s) const { return str.compare(s.str); }
+
+    bool startsWith(const String& prefix) const {
+        return str.compare(0, prefix.str.size(), prefix.str) == 0;
+    }
+    bool endsWith(const String& suffix) const {
+        return str.size() >= suffix.str.size() &&
+               str.compare(str.size() - suffix.str.size(), suffix.str.size(), suffix.str) == 0;
+    }
+    int indexOf(char c, unsigned int from = 0) const { return toIndex(str.find(c, from)); }
+    int indexOf(const String& s, unsigned int from = 0) const { return toIndex(str.find(s.str, from)); }
+    int lastIndexOf(char c) const { return toIndex(str.rfind(c)); }
+    String substring(unsigned int from) const { return from < str.size() ? String(str.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        if (from > to) std::swap(from, to);
+        return from < str.size() ? String(str.substr(from, to - from)) : String();
+    }
+    long toInt() const { return std::strtol(str.c_str(), nullptr, 10); }
+    float toFloat() const { return std::strtof(str.c_str(), nullptr); }
+    double toDouble() const { return std::strtod(str.c_str(), nullptr); }
+
+private:
+    std::string str;
+
+    static int toIndex(std::string::size_type pos) {
+        return pos == std::string::npos ? -1 : static_cast<int>(pos);
+    }
+    static std::string fromLong(long value, unsigned char base) {
+        if (value < 0 && base == 10) return "-" + fromULong(-static_cast<unsigned long>(value), base);
+        return fromULong(static_cast<unsigned long>(value), base);
+    }
+    static std::string fromULong(unsigned long value, unsigned char base) {
+        char buf[8 * sizeof(long) + 1];
+        char* p = buf + sizeof(buf) - 1;
+        *p = 0;
+        do {
+            unsigned digit = value % base;
+            *--p = static_cast<char>(digit < 10 ? '0' + digit : 'a' + digit - 10);
+            value /= base;
+        } while (value);
+        return p;
+    }
+    static std::string fromDouble(double value, unsigned char decimals) {
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "%.*f", decimals, value);
+        return buf;
+    }
+};
+
+class StringSumHelper : public String {
+public:
+    using String::String;
+    StringSumHelper(const String& s) : String(s) {}
+};
+
+template <typename T>
+StringSumHelper operator+(const String& lhs, const T& rhs) {
+    StringSumHelper result(lhs);
+    result.concat(rhs);
+    return result;
+}
+
+inline StringSumHelper operator+(const char* lhs, const String& rhs) {
+    StringSumHelper result(lhs);
+    result.concat(rhs);
+    return result;
+}
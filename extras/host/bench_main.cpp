@@ -0,0 +1,20 @@
+// Licensed under Apache License, Version 2.0
+// SPDX-License-Identifier: Apache-2.0
+// http://www.apache.org/licenses/LICENSE-2.0
+// © 2025 Lennart Gutjahr
+
+// Host entry point for examples/Benchmark. Usage: tinyconfig_bench [iterations]
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "TinyConfigBench.h"
+
+int main(int argc, char** argv) {
+    unsigned iterations = argc > 1 ? static_cast<unsigned>(std::atoi(argv[1])) : 20;
+    LittleFS.begin();
+    LittleFS.format();
+    LittleFS.end();
+    runTinyConfigBench(Serial, iterations);
+    Serial.flush();
+    return 0;
+}
@@ -0,0 +1,21 @@
+// Licensed under Apache License, Version 2.0
+// SPDX-License-Identifier: Apache-2.0
+// http://www.apache.org/licenses/LICENSE-2.0
+// © 2025 Lennart Gutjahr
+
+// Host entry point for test/full_test.cpp: starts from an empty filesystem,
+// like a freshly flashed board, and runs the Arduino setup() once.
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <unity.h>
+
+void setup();
+
+int main() {
+    LittleFS.begin();
+    LittleFS.format();
+    LittleFS.end();
+    setup();
+    return unityHost().failures == 0 ? 0 : 1;
+}
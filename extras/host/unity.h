@@ -0,0 +1,77 @@
+// Licensed under Apache License, Version 2.0
+// SPDX-License-Identifier: Apache-2.0
+// http://www.apache.org/licenses/LICENSE-2.0
+// © 2025 Lennart Gutjahr
+
+// Tiny host stand-in for the subset of Unity used by test/full_test.cpp.
+// A failing assertion aborts the current test, like Unity does.
+
+#pragma once
+#include <csetjmp>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+struct UnityHostState {
+    int tests = 0;
+    int failures = 0;
+    const char* current = "";
+    std::jmp_buf abortFrame;
+};
+
+inline UnityHostState& unityHost() {
+    static UnityHostState state;
+    return state;
+}
+
+inline void unityHostFail(const char* file, int line, const char* message) {
+    std::printf("%s:%d:%s:FAIL: %s\n", file, line, unityHost().current, message);
+    unityHost().failures++;
+    std::longjmp(unityHost().abortFrame, 1);
+}
+
+inline void unityHostRun(void (*test)(), const char* name, const char* file, int line) {
+    UnityHostState& state = unityHost();
+    state.current = name;
+    state.tests++;
+    if (setjmp(state.abortFrame) == 0) {
+        test();
+        std::printf("%s:%d:%s:PASS\n", file, line, name);
+    }
+}
+
+inline int unityHostEnd() {
+    UnityHostState& state = unityHost();
+    std::printf("\n-----------------------\n%d Tests %d Failures 0 Ignored\n%s\n",
+                state.tests, state.failures, state.failures ? "FAIL" : "OK");
+    return state.failures;
+}
+
+#define UNITY_BEGIN() (unityHost().tests = 0, unityHost().failures = 0)
+#define UNITY_END() unityHostEnd()
+#define RUN_TEST(fn) unityHostRun(fn, #fn, __FILE__, __LINE__)
+
+#define TEST_FAIL_MESSAGE(msg) unityHostFail(__FILE__, __LINE__, msg)
+#define TEST_ASSERT_MESSAGE(cond, msg) do { if (!(cond)) TEST_FAIL_MESSAGE(msg); } while (0)
+#define TEST_ASSERT(cond) TEST_ASSERT_MESSAGE(cond, "Expression Evaluated To FALSE")
+#define TEST_ASSERT_TRUE(cond) TEST_ASSERT_MESSAGE(cond, "Expected TRUE Was FALSE")
+#define TEST_ASSERT_FALSE(cond) TEST_ASSERT_MESSAGE(!(cond), "Expected FALSE Was TRUE")
+#define TEST_ASSERT_NULL(p) TEST_ASSERT_MESSAGE((p) == nullptr, "Expected NULL")
+#define TEST_ASSERT_NOT_NULL(p) TEST_ASSERT_MESSAGE((p) != nullptr, "Expected Non-NULL")
+
+#define TEST_ASSERT_EQUAL(expected, actual) \
+    TEST_ASSERT_MESSAGE((long long)(expected) == (long long)(actual), "Values Not Equal")
+#define TEST_ASSERT_EQUAL_INT(expected, actual) TEST_ASSERT_EQUAL(expected, actual)
+#define TEST_ASSERT_EQUAL_UINT32(expected, actual) TEST_ASSERT_EQUAL(expected, actual)
+#define TEST_ASSERT_NOT_EQUAL(expected, actual) \
+    TEST_ASSERT_MESSAGE((long long)(expected) != (long long)(actual), "Expected Not-Equal")
+#define TEST_ASSERT_GREATER_THAN(threshold, actual) \
+    TEST_ASSERT_MESSAGE((long long)(actual) > (long long)(threshold), "Expected Greater Than")
+#define TEST_ASSERT_LESS_THAN(threshold, actual) \
+    TEST_ASSERT_MESSAGE((long long)(actual) < (long long)(threshold), "Expected Less Than")
+#define TEST_ASSERT_LESS_OR_EQUAL(threshold, actual) \
+    TEST_ASSERT_MESSAGE((long long)(actual) <= (long long)(threshold), "Expected Less Or Equal")
+#define TEST_ASSERT_FLOAT_WITHIN(delta, expected, actual) \
+    TEST_ASSERT_MESSAGE(std::fabs((double)(expected) - (double)(actual)) <= (double)(delta), "Values Not Within Delta")
+#define TEST_ASSERT_EQUAL_STRING(expected, actual) \
+    TEST_ASSERT_MESSAGE(std::strcmp((expected), (actual)) == 0, "Strings Not Equal")
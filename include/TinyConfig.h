@@ -6,6 +6,11 @@
 #pragma once
 #include <LittleFS.h>
 #include <ArduinoJson.h>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <type_traits>
+#include <vector>
 
 enum class TinyConfigError {
     None,
@@ -19,6 +24,9 @@ enum class TinyConfigError {
     JsonSerializeFailed,
     FileSizeTooSmall,    
     FileSizeTooLarge,
+    TransactionNotActive,
+    BufferTooSmall,
+    ChecksumMismatch,
 };
 
 const std::unordered_map<TinyConfigError, String> TinyConfigErrorStrings = {
@@ -32,44 +40,448 @@ const std::unordered_map<TinyConfigError, String> TinyConfigErrorStrings = {
     {TinyConfigError::JsonParseFailed, "JSON parsing failed"},
     {TinyConfigError::JsonSerializeFailed, "JSON serialization failed"},
     {TinyConfigError::FileSizeTooSmall, "Configuration file size too small"},
-    {TinyConfigError::FileSizeTooLarge, "Configuration file size too large"}
+    {TinyConfigError::FileSizeTooLarge, "Configuration file size too large"},
+    {TinyConfigError::TransactionNotActive, "Transaction is not active"},
+    {TinyConfigError::BufferTooSmall, "Buffer too small"},
+    {TinyConfigError::ChecksumMismatch, "Configuration file checksum mismatch"}
 };
 
+/**
+ * @brief Computes the 32-bit FNV-1a hash of a key at compile time.
+ */
+constexpr uint32_t tinyConfigHash(const char* key, uint32_t hash = 2166136261u) {
+    return *key ? tinyConfigHash(key + 1, (hash ^ static_cast<uint8_t>(*key)) * 16777619u) : hash;
+}
+
+/**
+ * @brief A configuration key known at compile time. Create it with TC_KEY("name").
+ *
+ * The name must outlive the TinyConfig instance, which string literals do. It is used without being copied.
+ */
+struct TinyConfigKey {
+    const char* name;
+    uint32_t hash;
+};
+
+uint32_t tinyConfigCrc32(const uint8_t* data, size_t length, uint32_t crc = 0);
+
+// A key handle whose hash is computed by the compiler.
+#define TC_KEY(name) (TinyConfigKey{name, std::integral_constant<uint32_t, tinyConfigHash(name)>::value})
+
+// Receives one chunk of output; return false to stop.
+using TinyConfigChunkHandler = std::function<bool(const uint8_t* data, size_t length)>;
+
+/**
+ * @brief One key and value for TinyConfig::setMany(), written as {"key", value}.
+ *
+ * Neither key nor text is copied; they only have to live until setMany() returns, which temporaries do.
+ */
+struct TinyConfigEntry {
+    enum class Type {
+        Int,
+        Float,
+        Text,
+    };
+
+    TinyConfigEntry(const char* key, int value) : key(key), type(Type::Int), intValue(value) {}
+    TinyConfigEntry(const char* key, float value) : key(key), type(Type::Float), floatValue(value) {}
+    TinyConfigEntry(const char* key, double value) : key(key), type(Type::Float), floatValue(static_cast<float>(value)) {}
+    TinyConfigEntry(const char* key, const char* value) : key(key), type(Type::Text), text(value) {}
+    TinyConfigEntry(const char* key, const String& value) : key(key), type(Type::Text), text(value.c_str()) {}
+
+    const char* key;
+    Type type;
+    int intValue = 0;
+    float floatValue = 0.0f;
+    const char* text = nullptr;
+};
+
+/**
+ * @brief One entry of a defaults table for TinyConfig::registerDefaults(), written as {"key", value}.
+ *
+ * Declare the table const and PROGMEM to keep it in flash. Keys and texts may point to PROGMEM strings as well.
+ */
+struct TinyConfigDefault {
+    constexpr TinyConfigDefault()
+        : key(nullptr), type(TinyConfigEntry::Type::Int), intValue(0), floatValue(0.0f), text(nullptr) {}
+    constexpr TinyConfigDefault(const char* key, int value)
+        : key(key), type(TinyConfigEntry::Type::Int), intValue(value), floatValue(0.0f), text(nullptr) {}
+    constexpr TinyConfigDefault(const char* key, float value)
+        : key(key), type(TinyConfigEntry::Type::Float), intValue(0), floatValue(value), text(nullptr) {}
+    constexpr TinyConfigDefault(const char* key, double value)
+        : key(key), type(TinyConfigEntry::Type::Float), intValue(0), floatValue(static_cast<float>(value)), text(nullptr) {}
+    constexpr TinyConfigDefault(const char* key, const char* value)
+        : key(key), type(TinyConfigEntry::Type::Text), intValue(0), floatValue(0.0f), text(value) {}
+
+    const char* key;
+    TinyConfigEntry::Type type;
+    int intValue;
+    float floatValue;
+    const char* text;
+};
+
+/**
+ * @brief Where TinyConfig::getMany() stores one value, written as {"key", &variable, fallback}.
+ *
+ * Strings can go to a String or, written as {"key", buffer, sizeof(buffer), fallback}, to a char buffer.
+ * The key is not copied.
+ */
+struct TinyConfigTarget {
+    enum class Type {
+        Int,
+        Float,
+        String,
+        Buffer,
+    };
+
+    TinyConfigTarget(const char* key, int* value, int fallback = 0)
+        : key(key), type(Type::Int), target(value), intFallback(fallback) {}
+    TinyConfigTarget(const char* key, float* value, float fallback = 0.0f)
+        : key(key), type(Type::Float), target(value), floatFallback(fallback) {}
+    TinyConfigTarget(const char* key, String* value, const char* fallback = "")
+        : key(key), type(Type::String), target(value), textFallback(fallback) {}
+    TinyConfigTarget(const char* key, char* buffer, size_t length, const char* fallback = "")
+        : key(key), type(Type::Buffer), target(buffer), length(length), textFallback(fallback) {}
+
+    const char* key;
+    Type type;
+    void* target;
+    size_t length = 0;
+    int intFallback = 0;
+    float floatFallback = 0.0f;
+    const char* textFallback = "";
+};
+
+// Receives the new value of a key; the value is null if the key was deleted or the configuration reset.
+using TinyConfigChangeHandler = std::function<void(const char* key, ArduinoJson::JsonVariantConst value)>;
+
+enum class TinyConfigFormat {
+    Json,
+    MessagePack,
+    Indexed,
+};
+
+struct TinyConfigStats {
+    uint32_t loadCount = 0;          // configuration file loads (loadDoc calls that opened the file)
+    uint32_t saveCount = 0;          // configuration file saves (saveDoc calls that opened the file)
+    uint32_t flashWrites = 0;        // files successfully written, including resets
+    uint32_t bytesParsed = 0;        // bytes read by deserializeJson
+    uint32_t bytesSerialized = 0;    // bytes written by serializeJson
+    uint32_t parseMicros = 0;        // cumulative time in deserializeJson
+    uint32_t parseMaxMicros = 0;     // longest single deserializeJson call
+    uint32_t serializeMicros = 0;    // cumulative time in serializeJson
+    uint32_t serializeMaxMicros = 0; // longest single serializeJson call
+    uint32_t fsMicros = 0;           // cumulative time in LittleFS open/close
+    uint32_t fsMaxMicros = 0;        // longest single LittleFS open/close
+    uint32_t logAppends = 0;         // records appended to the log in log mode
+    uint32_t compactions = 0;        // snapshots written in log mode
+};
+
+template <typename T>
+class TinyConfigRef;
+
 class TinyConfig {
 public:
+    class Transaction {
+    public:
+        Transaction(Transaction&& other);
+
+        bool set(const String& key, int value);
+        bool set(const String& key, float value);
+        bool set(const String& key, const String& value);
+        bool deleteKey(const String& key);
+
+        bool commit();
+        void rollback();
+        bool isActive() const;
+
+    private:
+        friend class TinyConfig;
+        explicit Transaction(TinyConfig& owner);
+
+        TinyConfig* owner;
+        ArduinoJson::DynamicJsonDocument doc;
+        bool active = false;
+
+        template <typename T>
+        bool setInternal(const String& key, T value);
+    };
+
+    explicit TinyConfig(const char* name = "config");
+
     bool StartTC();
     bool StopTC();
     bool resetConfig();
     bool setMaxFileSize(size_t maxSize);
+    bool setCacheMode(bool enabled);
+    bool setReuseParseBuffer(bool enabled);
+    bool setWriteBack(bool enabled);
+    bool commit();
+    bool isDirty() const;
+    bool setFlushDelay(uint32_t ms);
+    bool tick();
+    bool flushNow();
+    bool setFormat(TinyConfigFormat newFormat);
+    TinyConfigFormat getFormat() const;
+    bool setLogMode(bool enabled);
+    bool setAtomicSave(bool enabled);
+    bool setFileHeader(bool enabled);
+    bool setCompactThreshold(size_t logSize);
+    bool compact();
     
     TinyConfigError getLastError() const;
     String getLastErrorString() const;
 
+    const TinyConfigStats& getStats() const;
+    void resetStats();
+
     bool set(const String& key, int value);
     bool set(const String& key, float value);
     bool set(const String& key, const String& value);
+    bool set(TinyConfigKey key, int value);
+    bool set(TinyConfigKey key, float value);
+    bool set(TinyConfigKey key, const String& value);
 
     bool deleteKey(const String& key);
+    bool deleteKey(TinyConfigKey key);
     bool deleteKeys(const String keys[], size_t& count);
     bool deleteKeys(const std::vector<String>& keys);
 
     int getInt(const String& key, int fallback = 0);
     float getFloat(const String& key, float fallback = 0.0f);
     String getString(const String& key, const String& fallback = "");
+    int getInt(TinyConfigKey key, int fallback = 0);
+    float getFloat(TinyConfigKey key, float fallback = 0.0f);
+    String getString(TinyConfigKey key, const String& fallback = "");
+    bool getString(const String& key, char* buffer, size_t length, const char* fallback = "");
+    bool getString(TinyConfigKey key, char* buffer, size_t length, const char* fallback = "");
+    bool getMany(std::initializer_list<TinyConfigTarget> targets);
+    bool getMany(const TinyConfigTarget* targets, size_t count);
 
     String getAll(const String& fallback = "{}");
+    bool getAll(Print& out);
+    bool getAll(const TinyConfigChunkHandler& handler);
     DynamicJsonDocument getAllJson();
 
+    void registerDefaults(const TinyConfigDefault* table, size_t count);
+    template <size_t N>
+    void registerDefaults(const TinyConfigDefault (&table)[N]) {
+        registerDefaults(table, N);
+    }
+    bool setMergeDefaults(bool enabled);
+
+    Transaction beginTransaction();
+    bool setMany(std::initializer_list<TinyConfigEntry> entries);
+    bool merge(ArduinoJson::JsonObjectConst changes);
+
+    /**
+     * @brief Binds a typed handle to a key; see TinyConfigRef.
+     * @tparam T int, float or String.
+     * @param key The key to bind.
+     * @param fallback The value get() returns if the key does not exist or on error.
+     */
+    template <typename T>
+    TinyConfigRef<T> ref(const String& key, T fallback = T()) {
+        return TinyConfigRef<T>(*this, key, fallback);
+    }
+
+    void onChange(const String& key, TinyConfigChangeHandler handler);
+    void removeOnChange(const String& key);
+
+protected:
+    void useStaticDoc(ArduinoJson::JsonDocument& document);
+
 private:
+    template <typename T>
+    friend class TinyConfigRef;
+
     TinyConfigError lastError = TinyConfigError::None;
+    TinyConfigStats stats;
     bool newFile();
-    const char* FileString = "/config.json";
+    String FileString;        // /<name>.json
+    String MsgPackFileString; // /<name>.msgpack
+    String IndexFileString;   // /<name>.idx
+    TinyConfigFormat format = TinyConfigFormat::Json;
     bool isInitialized = false;
     size_t maxFileSize = 2048;
+    size_t fileBytes = 0; // document length at the last load or save, 0 if not known
 
-    bool loadDoc(ArduinoJson::DynamicJsonDocument& doc);
-    bool saveDoc(const ArduinoJson::DynamicJsonDocument& doc);
+    bool cacheEnabled = false;
+    bool cacheValid = false;
+    bool writeBack = false;
+    bool dirty = false;
+    uint32_t flushDelay = 0;       // quiet period in ms before tick() commits, 0 to wait for commit()
+    uint32_t lastChangeMillis = 0; // millis() of the last buffered change
+    size_t cacheBytes = 0; // serialized size of cacheDoc, 0 if not known
+    std::unique_ptr<ArduinoJson::DynamicJsonDocument> cacheDoc;
+    ArduinoJson::JsonDocument* staticDoc = nullptr; // document inside TinyConfigStatic, used instead of cacheDoc
+    uint32_t generation = 1; // changes whenever the configuration may have changed
+    bool reuseParseBuffer = false;
+    std::unique_ptr<ArduinoJson::DynamicJsonDocument> parseDoc; // kept between loads when reuseParseBuffer is set
 
+    struct KeySlot {
+        const char* name = nullptr;
+        uint32_t hash = 0;
+        uint32_t generation = 0;
+        ArduinoJson::JsonVariantConst value;
+    };
+    static const size_t KeySlotCount = 8;
+    static const size_t MemberDocSize = 128; // stack document for a single member parsed with a filter
+    std::unique_ptr<KeySlot[]> keySlots; // recent TinyConfigKey lookups in the cached document
+
+    bool logMode = false;
+    String LogFileString;      // /<name>.log
+    String SnapshotTempString; // /<name>.tmp
+    size_t logBytes = 0;
+    size_t compactThreshold = 2048;
+
+    // Header in front of the document: magic "TC", version, format, generation, length and CRC32 of the document
+    struct FileHeader {
+        uint8_t format;
+        uint32_t generation;
+        uint32_t length;
+        uint32_t crc;
+    };
+    static const size_t FileHeaderSize = 16;
+    static const uint8_t FileHeaderVersion = 1;
+    bool fileHeader = false;
+    bool atomicSave = false;
+    String SlotFileStrings[2]; // /<name>.a and /<name>.b
+    uint8_t activeSlot = 1;
+    uint32_t slotGeneration = 0; // generation of the active copy, 0 if there is none
+
+    const TinyConfigDefault* defaults = nullptr; // table in flash, see registerDefaults()
+    size_t defaultCount = 0;
+    bool mergeDefaults = false;
+
+    struct ChangeSubscription {
+        String key;
+        TinyConfigChangeHandler handler;
+    };
+    std::vector<ChangeSubscription> changeSubscriptions;
+
+    bool isResident() const;
+    const char* configPath(TinyConfigFormat fileFormat) const;
+    size_t measureDoc(ArduinoJson::JsonVariantConst value) const;
+    size_t measureValue(ArduinoJson::JsonVariantConst value) const;
+    size_t serializeDoc(const ArduinoJson::JsonDocument& doc, Print& out) const;
+    ArduinoJson::DeserializationError deserializeDoc(ArduinoJson::JsonDocument& doc, Stream& in, TinyConfigFormat fileFormat, const ArduinoJson::JsonDocument* filter = nullptr) const;
+    bool migrateConfig();
+    void removeConfigFiles(bool keepCurrent);
+    bool migrateSlots();
+    bool openConfig();
+    bool resetFiles();
+    bool selectSlot();
+    bool readFileHeader(File& file, FileHeader& header);
+    bool readSlotHeader(uint8_t slot, FileHeader& header);
+    bool parseFile(File& file, ArduinoJson::JsonDocument& doc, TinyConfigFormat fileFormat, const ArduinoJson::JsonDocument* filter = nullptr);
+    bool verifyConfig();
+    bool loadSlot(ArduinoJson::JsonDocument& doc, const ArduinoJson::JsonDocument* filter = nullptr);
+    bool writeSlot(const ArduinoJson::JsonDocument& doc);
+    File openFile(const char* path, const char* mode);
+    void closeFile(File& file);
+    bool loadDoc(ArduinoJson::JsonDocument& doc, const ArduinoJson::JsonDocument* filter = nullptr);
+    bool saveDoc(const ArduinoJson::JsonDocument& doc);
+    bool writeDoc(const ArduinoJson::JsonDocument& doc, const char* path, bool header = false, uint32_t headerGeneration = 0);
+    bool recoverSnapshot();
+    bool replayLog(ArduinoJson::JsonDocument& doc);
+    bool appendLog(const ArduinoJson::JsonDocument& patch);
+    ArduinoJson::JsonDocument* openDoc(std::unique_ptr<ArduinoJson::DynamicJsonDocument>& scratch);
+    ArduinoJson::JsonDocument* mergedDoc(std::unique_ptr<ArduinoJson::DynamicJsonDocument>& scratch);
+    bool storeDoc(ArduinoJson::JsonDocument& doc, size_t bytes = 0, const ArduinoJson::JsonDocument* patch = nullptr);
+    bool replaceDoc(ArduinoJson::DynamicJsonDocument& doc);
+    ArduinoJson::JsonDocument* cachedDoc() const;
+    bool compactDoc(ArduinoJson::JsonDocument& doc);
+    void notifyChanges(ArduinoJson::JsonObjectConst changes, bool wholeConfig, const std::vector<bool>* changed = nullptr);
+    std::vector<bool> changedKeys(ArduinoJson::JsonDocument& next);
+    ArduinoJson::JsonVariantConst findMember(ArduinoJson::JsonDocument& doc, const String& key);
+    ArduinoJson::JsonVariantConst findMember(ArduinoJson::JsonDocument& doc, TinyConfigKey key);
+
+    template <typename K, typename T>
+    bool fitsAfterSet(ArduinoJson::JsonDocument& doc, const K& key, const T& value, size_t& fileSize);
+
+    template <typename K, typename T>
+    bool setInternal(const K& key, T value);
+    template <typename K, typename T>
+    T getInternal(const K& key, T fallback);
+    template <typename K>
+    bool deleteInternal(const K& key);
+    template <typename K>
+    bool loadMember(const K& key, ArduinoJson::JsonDocument& member);
+    ArduinoJson::JsonDocument& memberDoc(ArduinoJson::JsonDocument& small, std::unique_ptr<ArduinoJson::DynamicJsonDocument>& large, bool text);
+    bool seekMember(const char* key, uint32_t hash, ArduinoJson::JsonDocument& member);
+    bool patchMember(const char* key, uint32_t hash, uint8_t type, uint32_t bits, bool& changed);
+    template <typename K>
+    bool copyString(const K& key, char* buffer, size_t length, const char* fallback);
+    bool copyMember(const char* text, char* buffer, size_t length);
+    bool findDefault(const char* key, TinyConfigDefault& entry) const;
     template <typename T>
-    bool setInternal(const String& key, T value);
-};
\ No newline at end of file
+    T defaultOr(const char* key, T fallback) const;
+    bool copyDefault(const char* key, const char* fallback, char* buffer, size_t length);
+    size_t defaultsSize() const;
+    void addDefaults(ArduinoJson::JsonDocument& doc) const;
+};
+
+/**
+ * @brief A typed handle to one key, created with TinyConfig::ref(). It must not outlive its TinyConfig.
+ * @tparam T int, float or String.
+ *
+ * The handle keeps the value it read last together with TinyConfig's generation number, which changes with every
+ * write through TinyConfig and on every start. As long as it has not changed, get() is a compare and a copy;
+ * afterwards the value is read again once. Like cache mode, changes made to the file by other code are not seen.
+ */
+template <typename T>
+class TinyConfigRef {
+public:
+    static_assert(std::is_same<T, int>::value || std::is_same<T, float>::value || std::is_same<T, String>::value,
+                  "TinyConfigRef supports int, float and String");
+
+    T get() {
+        if (!valid || generation != owner->generation) {
+            value = owner->template getInternal<String, T>(key, fallback);
+            valid = owner->getLastError() == TinyConfigError::None;
+            generation = owner->generation;
+        }
+        return value;
+    }
+
+    operator T() { return get(); }
+
+    bool set(const T& newValue) { return owner->set(key, newValue); }
+
+    const String& getKey() const { return key; }
+
+private:
+    friend class TinyConfig;
+    TinyConfigRef(TinyConfig& owner, const String& key, T fallback)
+        : owner(&owner), key(key), fallback(fallback), value(fallback) {}
+
+    TinyConfig* owner;
+    String key;
+    T fallback;
+    T value;
+    uint32_t generation = 0;
+    bool valid = false;
+};
+
+/**
+ * @brief A TinyConfig that keeps the configuration in a document of N bytes inside the object instead of on the heap.
+ * @tparam N Capacity of the document in bytes, like StaticJsonDocument<N>.
+ *
+ * The configuration is always kept in RAM, like in cache mode, so its memory is known at link time and getters,
+ * set(), deleteKey() and resetConfig() do not allocate, apart from the small lookup table of TC_KEY() keys on first
+ * use. Transactions, deleteKeys(), getAllJson(), the String getters and log mode still use the heap; LittleFS
+ * allocates its file handles itself. N limits the document in RAM, setMaxFileSize() still limits the file.
+ */
+template <size_t N>
+class TinyConfigStatic : public TinyConfig {
+public:
+    explicit TinyConfigStatic(const char* name = "config") : TinyConfig(name) {
+        useStaticDoc(document);
+    }
+    TinyConfigStatic(const TinyConfigStatic&) = delete;
+    TinyConfigStatic& operator=(const TinyConfigStatic&) = delete;
+
+private:
+    ArduinoJson::StaticJsonDocument<N> document;
+};
@@ -0,0 +1,107 @@
+// Licensed under Apache License, Version 2.0
+// SPDX-License-Identifier: Apache-2.0
+// http://www.apache.org/licenses/LICENSE-2.0
+// © 2025 Lennart Gutjahr
+
+#pragma once
+#include "TinyConfig.h"
+#include <stddef.h>
+#include <type_traits>
+
+enum class TinyConfigFieldType {
+    Int,
+    Float,
+    String,
+};
+
+/**
+ * @brief Describes one member of a settings struct: its key, type, position and default value.
+ *
+ * Fields are created with TC_FIELD() or TC_FIELD_KEY() and are constant expressions, so a schema costs no code at runtime.
+ */
+struct TinyConfigField {
+    const char* key;
+    TinyConfigFieldType type;
+    size_t offset;
+    size_t size;
+    int intDefault;
+    float floatDefault;
+    const char* stringDefault;
+};
+
+constexpr TinyConfigField tinyConfigField(const char* key, size_t offset, int*, int fallback) {
+    return {key, TinyConfigFieldType::Int, offset, sizeof(int), fallback, 0.0f, nullptr};
+}
+
+constexpr TinyConfigField tinyConfigField(const char* key, size_t offset, float*, float fallback) {
+    return {key, TinyConfigFieldType::Float, offset, sizeof(float), 0, fallback, nullptr};
+}
+
+template <size_t N>
+constexpr TinyConfigField tinyConfigField(const char* key, size_t offset, char (*)[N], const char* fallback) {
+    return {key, TinyConfigFieldType::String, offset, N, 0, 0.0f, fallback};
+}
+
+// Maps a member of a settings struct to the configuration key of the same name.
+#define TC_FIELD(type, member, fallback) \
+    tinyConfigField(#member, offsetof(type, member), static_cast<decltype(type::member)*>(nullptr), fallback)
+
+// Maps a member of a settings struct to a configuration key with a different name.
+#define TC_FIELD_KEY(type, member, key, fallback) \
+    tinyConfigField(key, offsetof(type, member), static_cast<decltype(type::member)*>(nullptr), fallback)
+
+void tinyConfigApplyDefaults(const TinyConfigField* fields, size_t count, void* data);
+bool tinyConfigLoadFields(TinyConfig& config, const TinyConfigField* fields, size_t count, void* data);
+bool tinyConfigSaveFields(TinyConfig& config, const TinyConfigField* fields, size_t count, const void* data);
+
+/**
+ * @brief Keeps a configuration with keys known at compile time in a plain struct.
+ * @tparam T The settings struct. Members must be int, float or char arrays; T must be standard layout.
+ * @tparam N Number of fields in the schema.
+ *
+ * The struct is filled by load() with a single read of the configuration, and reading a setting afterwards is a plain
+ * member access. Missing or mistyped keys get the default value of their field; strings longer than their array are
+ * cut. save() writes all fields with a single file write.
+ */
+template <typename T, size_t N>
+class TinyConfigSchema {
+public:
+    TinyConfigSchema(TinyConfig& config, const TinyConfigField (&fields)[N]) : config(config), fields(fields) {
+        reset();
+    }
+
+    /**
+     * @brief Reads all fields from the configuration.
+     * @return true if the configuration was read, false otherwise. On failure, all fields hold their defaults; check getLastError() or getLastErrorString() of the TinyConfig instance for details.
+     */
+    bool load() {
+        return tinyConfigLoadFields(config, fields, N, &settings);
+    }
+
+    /**
+     * @brief Writes all fields to the configuration with a single file write.
+     * @return true if the configuration was written, false otherwise. On failure, check getLastError() or getLastErrorString() of the TinyConfig instance for details.
+     */
+    bool save() {
+        return tinyConfigSaveFields(config, fields, N, &settings);
+    }
+
+    /**
+     * @brief Sets all fields to their defaults without touching the configuration.
+     */
+    void reset() {
+        tinyConfigApplyDefaults(fields, N, &settings);
+    }
+
+    T& data() { return settings; }
+    const T& data() const { return settings; }
+    T* operator->() { return &settings; }
+    const T* operator->() const { return &settings; }
+
+private:
+    static_assert(std::is_standard_layout<T>::value, "TinyConfigSchema needs a standard layout struct");
+
+    TinyConfig& config;
+    const TinyConfigField* fields;
+    T settings;
+};
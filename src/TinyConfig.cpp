@@ -4,14 +4,657 @@
 // © 2025 Lennart Gutjahr
 
 #include "TinyConfig.h"
+#include <algorithm>
 using namespace ArduinoJson;
 
+namespace {
+
+// Values as they can be stored in a probe document without copying.
+template <typename T>
+T probeValue(const T& value) {
+    return value;
+}
+
+const char* probeValue(const String& value) {
+    return value.c_str();
+}
+
+// Bytes ArduinoJson needs to copy a value into a document's memory pool.
+template <typename T>
+size_t copiedSize(const T&) {
+    return 0;
+}
+
+size_t copiedSize(const String& value) {
+    return value.length() + 1;
+}
+
+// Keys as passed to ArduinoJson: Strings are copied into the document, TinyConfigKey names are linked.
+const String& jsonKey(const String& key) {
+    return key;
+}
+
+const char* jsonKey(const TinyConfigKey& key) {
+    return key.name;
+}
+
+// Key text for short-lived probe and patch documents.
+const char* keyChars(const String& key) {
+    return key.c_str();
+}
+
+const char* keyChars(const TinyConfigKey& key) {
+    return key.name;
+}
+
+size_t keyLength(const String& key) {
+    return key.length();
+}
+
+size_t keyLength(const TinyConfigKey& key) {
+    return strlen(key.name);
+}
+
+// Copies text into a buffer of the given length, cutting it if needed. Returns false if it was cut.
+bool copyText(const char* text, char* buffer, size_t length) {
+    size_t textLength = strlen(text);
+    if (textLength >= length) {
+        memcpy(buffer, text, length - 1);
+        buffer[length - 1] = '\0';
+        return false;
+    }
+    memcpy(buffer, text, textLength + 1);
+    return true;
+}
+
+// Like copyText(), for text stored in flash.
+bool copyFlashText(const char* text, char* buffer, size_t length) {
+    size_t textLength = strlen_P(text);
+    bool complete = textLength < length;
+    if (!complete) {
+        textLength = length - 1;
+    }
+    memcpy_P(buffer, text, textLength);
+    buffer[textLength] = '\0';
+    return complete;
+}
+
+// Copies text stored in flash into a String.
+String flashString(const char* text) {
+    String result;
+    size_t remaining = strlen_P(text);
+    result.reserve(remaining);
+    char chunk[32];
+    while (remaining > 0) {
+        size_t count = remaining < sizeof(chunk) ? remaining : sizeof(chunk);
+        memcpy_P(chunk, text, count);
+        result.concat(chunk, count);
+        text += count;
+        remaining -= count;
+    }
+    return result;
+}
+
+// Converts an entry of the defaults table to the type a getter returns, or returns fallback if the types do not match.
+int defaultValue(const TinyConfigDefault& entry, int fallback) {
+    return entry.type == TinyConfigEntry::Type::Int ? entry.intValue : fallback;
+}
+
+float defaultValue(const TinyConfigDefault& entry, float fallback) {
+    switch (entry.type) {
+        case TinyConfigEntry::Type::Int:
+            return static_cast<float>(entry.intValue);
+        case TinyConfigEntry::Type::Float:
+            return entry.floatValue;
+        default:
+            return fallback;
+    }
+}
+
+String defaultValue(const TinyConfigDefault& entry, const String& fallback) {
+    return entry.type == TinyConfigEntry::Type::Text && entry.text ? flashString(entry.text) : fallback;
+}
+
+// Adds the time since start to a cumulative and a maximum counter.
+void addTiming(uint32_t& total, uint32_t& peak, uint32_t start) {
+    uint32_t elapsed = micros() - start;
+    total += elapsed;
+    if (elapsed > peak) {
+        peak = elapsed;
+    }
+}
+
+// Collects small writes from serializeJson and passes them on in blocks, so a document
+// reaches the file in a few large writes instead of one call per token.
+class BufferedWriter : public Print {
+public:
+    explicit BufferedWriter(Print& target) : target(target) {}
+
+    size_t write(uint8_t c) override {
+        if (used == sizeof(buffer) && !finish()) {
+            return 0;
+        }
+        buffer[used++] = c;
+        return 1;
+    }
+
+    size_t write(const uint8_t* data, size_t size) override {
+        for (size_t i = 0; i < size; ++i) {
+            if (!write(data[i])) {
+                return i;
+            }
+        }
+        return size;
+    }
+
+    // Writes the buffered bytes; false if the target did not accept all of them.
+    bool finish() {
+        if (used > 0 && target.write(buffer, used) != used) {
+            failed = true;
+        }
+        used = 0;
+        return !failed;
+    }
+
+private:
+    Print& target;
+    uint8_t buffer[128];
+    size_t used = 0;
+    bool failed = false;
+};
+
+// CRC-32 (IEEE 802.3, reflected polynomial 0xEDB88320) of every byte value
+const uint32_t crcTable[256] PROGMEM = {
+    0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
+    0xe963a535, 0x9e6495a3, 0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988,
+    0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91, 0x1db71064, 0x6ab020f2,
+    0xf3b97148, 0x84be41de, 0x1adad47d, 0x6ddde4eb, 0xf4d4b551, 0x83d385c7,
+    0x136c9856, 0x646ba8c0, 0xfd62f97a, 0x8a65c9ec, 0x14015c4f, 0x63066cd9,
+    0xfa0f3d63, 0x8d080df5, 0x3b6e20c8, 0x4c69105e, 0xd56041e4, 0xa2677172,
+    0x3c03e4d1, 0x4b04d447, 0xd20d85fd, 0xa50ab56b, 0x35b5a8fa, 0x42b2986c,
+    0xdbbbc9d6, 0xacbcf940, 0x32d86ce3, 0x45df5c75, 0xdcd60dcf, 0xabd13d59,
+    0x26d930ac, 0x51de003a, 0xc8d75180, 0xbfd06116, 0x21b4f4b5, 0x56b3c423,
+    0xcfba9599, 0xb8bda50f, 0x2802b89e, 0x5f058808, 0xc60cd9b2, 0xb10be924,
+    0x2f6f7c87, 0x58684c11, 0xc1611dab, 0xb6662d3d, 0x76dc4190, 0x01db7106,
+    0x98d220bc, 0xefd5102a, 0x71b18589, 0x06b6b51f, 0x9fbfe4a5, 0xe8b8d433,
+    0x7807c9a2, 0x0f00f934, 0x9609a88e, 0xe10e9818, 0x7f6a0dbb, 0x086d3d2d,
+    0x91646c97, 0xe6635c01, 0x6b6b51f4, 0x1c6c6162, 0x856530d8, 0xf262004e,
+    0x6c0695ed, 0x1b01a57b, 0x8208f4c1, 0xf50fc457, 0x65b0d9c6, 0x12b7e950,
+    0x8bbeb8ea, 0xfcb9887c, 0x62dd1ddf, 0x15da2d49, 0x8cd37cf3, 0xfbd44c65,
+    0x4db26158, 0x3ab551ce, 0xa3bc0074, 0xd4bb30e2, 0x4adfa541, 0x3dd895d7,
+    0xa4d1c46d, 0xd3d6f4fb, 0x4369e96a, 0x346ed9fc, 0xad678846, 0xda60b8d0,
+    0x44042d73, 0x33031de5, 0xaa0a4c5f, 0xdd0d7cc9, 0x5005713c, 0x270241aa,
+    0xbe0b1010, 0xc90c2086, 0x5768b525, 0x206f85b3, 0xb966d409, 0xce61e49f,
+    0x5edef90e, 0x29d9c998, 0xb0d09822, 0xc7d7a8b4, 0x59b33d17, 0x2eb40d81,
+    0xb7bd5c3b, 0xc0ba6cad, 0xedb88320, 0x9abfb3b6, 0x03b6e20c, 0x74b1d29a,
+    0xead54739, 0x9dd277af, 0x04db2615, 0x73dc1683, 0xe3630b12, 0x94643b84,
+    0x0d6d6a3e, 0x7a6a5aa8, 0xe40ecf0b, 0x9309ff9d, 0x0a00ae27, 0x7d079eb1,
+    0xf00f9344, 0x8708a3d2, 0x1e01f268, 0x6906c2fe, 0xf762575d, 0x806567cb,
+    0x196c3671, 0x6e6b06e7, 0xfed41b76, 0x89d32be0, 0x10da7a5a, 0x67dd4acc,
+    0xf9b9df6f, 0x8ebeeff9, 0x17b7be43, 0x60b08ed5, 0xd6d6a3e8, 0xa1d1937e,
+    0x38d8c2c4, 0x4fdff252, 0xd1bb67f1, 0xa6bc5767, 0x3fb506dd, 0x48b2364b,
+    0xd80d2bda, 0xaf0a1b4c, 0x36034af6, 0x41047a60, 0xdf60efc3, 0xa867df55,
+    0x316e8eef, 0x4669be79, 0xcb61b38c, 0xbc66831a, 0x256fd2a0, 0x5268e236,
+    0xcc0c7795, 0xbb0b4703, 0x220216b9, 0x5505262f, 0xc5ba3bbe, 0xb2bd0b28,
+    0x2bb45a92, 0x5cb36a04, 0xc2d7ffa7, 0xb5d0cf31, 0x2cd99e8b, 0x5bdeae1d,
+    0x9b64c2b0, 0xec63f226, 0x756aa39c, 0x026d930a, 0x9c0906a9, 0xeb0e363f,
+    0x72076785, 0x05005713, 0x95bf4a82, 0xe2b87a14, 0x7bb12bae, 0x0cb61b38,
+    0x92d28e9b, 0xe5d5be0d, 0x7cdcefb7, 0x0bdbdf21, 0x86d3d2d4, 0xf1d4e242,
+    0x68ddb3f8, 0x1fda836e, 0x81be16cd, 0xf6b9265b, 0x6fb077e1, 0x18b74777,
+    0x88085ae6, 0xff0f6a70, 0x66063bca, 0x11010b5c, 0x8f659eff, 0xf862ae69,
+    0x616bffd3, 0x166ccf45, 0xa00ae278, 0xd70dd2ee, 0x4e048354, 0x3903b3c2,
+    0xa7672661, 0xd06016f7, 0x4969474d, 0x3e6e77db, 0xaed16a4a, 0xd9d65adc,
+    0x40df0b66, 0x37d83bf0, 0xa9bcae53, 0xdebb9ec5, 0x47b2cf7f, 0x30b5ffe9,
+    0xbdbdf21c, 0xcabac28a, 0x53b39330, 0x24b4a3a6, 0xbad03605, 0xcdd70693,
+    0x54de5729, 0x23d967bf, 0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94,
+    0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
+};
+
+void putU32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+const uint8_t FileMagic[2] = {'T', 'C'};
+
+uint32_t getU32(const uint8_t* in) {
+    return in[0] | (in[1] << 8) | (in[2] << 16) | (static_cast<uint32_t>(in[3]) << 24);
+}
+
+// Passes everything written to it on to another Print and checksums what was accepted.
+class ChecksumWriter : public Print {
+public:
+    explicit ChecksumWriter(Print& target) : target(target) {}
+
+    size_t write(uint8_t c) override {
+        return write(&c, 1);
+    }
+
+    size_t write(const uint8_t* data, size_t size) override {
+        size_t written = target.write(data, size);
+        checksum = tinyConfigCrc32(data, written, checksum);
+        return written;
+    }
+
+    uint32_t checksum = 0;
+
+private:
+    Print& target;
+};
+
+// Reads at most length bytes from another Stream and checksums them.
+class ChecksumReader : public Stream {
+public:
+    ChecksumReader(Stream& source, size_t length) : source(source), remaining(length) {}
+
+    int available() override {
+        return remaining < static_cast<size_t>(source.available()) ? remaining : source.available();
+    }
+
+    int read() override {
+        uint8_t c;
+        return readBytes(reinterpret_cast<char*>(&c), 1) == 1 ? c : -1;
+    }
+
+    int peek() override {
+        return remaining > 0 ? source.peek() : -1;
+    }
+
+    size_t readBytes(char* buffer, size_t length) override {
+        size_t count = source.readBytes(buffer, length < remaining ? length : remaining);
+        checksum = tinyConfigCrc32(reinterpret_cast<const uint8_t*>(buffer), count, checksum);
+        remaining -= count;
+        return count;
+    }
+
+    size_t write(uint8_t) override {
+        return 0;
+    }
+
+    // Reads what the parser left unread, so the checksum covers all bytes. False if the stream ended early.
+    bool finish() {
+        char buffer[32];
+        while (remaining > 0) {
+            if (readBytes(buffer, sizeof(buffer)) == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    uint32_t checksum = 0;
+
+private:
+    Stream& source;
+    size_t remaining;
+};
+
+// Running instances; the filesystem is unmounted when the last one stops.
+uint8_t mountCount = 0;
+
+// Passes everything written to it on to a chunk handler.
+class ChunkWriter : public Print {
+public:
+    explicit ChunkWriter(const TinyConfigChunkHandler& handler) : handler(handler) {}
+
+    size_t write(uint8_t c) override {
+        return write(&c, 1);
+    }
+
+    size_t write(const uint8_t* data, size_t size) override {
+        return handler(data, size) ? size : 0;
+    }
+
+private:
+    const TinyConfigChunkHandler& handler;
+};
+
+// Indexed format: a preamble, an index of (key hash, member offset) sorted by hash, then the members as a MessagePack
+// map in index order. Ints are always stored as int32 and floats as float32, so they can be overwritten in place.
+const uint8_t IndexMagic[2] = {0xc1, 'I'}; // 0xc1 is never used by MessagePack, and is neither '{' nor the header's 'T'
+const uint8_t IndexVersion = 1;
+const size_t IndexPreambleSize = 8; // magic, version, reserved byte, member count
+const size_t IndexEntrySize = 8;    // key hash, offset of the member from the start of the document
+const uint8_t PackedInt = 0xd2;     // MessagePack int32
+const uint8_t PackedFloat = 0xca;   // MessagePack float32
+
+// The FNV-1a hash of tinyConfigHash(), computed at runtime.
+uint32_t hashKey(const char* key) {
+    uint32_t hash = 2166136261u;
+    while (*key) {
+        hash = (hash ^ static_cast<uint8_t>(*key++)) * 16777619u;
+    }
+    return hash;
+}
+
+uint32_t keyHash(const String& key) {
+    return hashKey(key.c_str());
+}
+
+uint32_t keyHash(const TinyConfigKey& key) {
+    return key.hash;
+}
+
+void putBE32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (24 - 8 * i));
+    }
+}
+
+uint32_t getBE(const uint8_t* in, size_t size) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < size; ++i) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+// is<float>() is true for integers as well.
+bool isFloat(JsonVariantConst value) {
+    return value.is<float>() && !value.is<long long>() && !value.is<unsigned long long>();
+}
+
+// Fixed-width encodings of values that set() can overwrite in place; false for values of variable width.
+bool packFixed(int value, uint8_t& type, uint32_t& bits) {
+    type = PackedInt;
+    bits = static_cast<uint32_t>(value);
+    return true;
+}
+
+bool packFixed(float value, uint8_t& type, uint32_t& bits) {
+    type = PackedFloat;
+    memcpy(&bits, &value, sizeof(bits));
+    return true;
+}
+
+bool packFixed(const String&, uint8_t&, uint32_t&) {
+    return false;
+}
+
+size_t packedStringHeaderSize(size_t length) {
+    return length < 32 ? 1 : (length < 256 ? 2 : (length < 65536 ? 3 : 5));
+}
+
+size_t packedMapHeaderSize(size_t count) {
+    return count < 16 ? 1 : (count < 65536 ? 3 : 5);
+}
+
+size_t measureIndexedValue(JsonVariantConst value) {
+    return value.is<int32_t>() || isFloat(value) ? 5 : measureMsgPack(value);
+}
+
+size_t measureIndexed(JsonObjectConst root) {
+    size_t size = IndexPreambleSize + root.size() * IndexEntrySize + packedMapHeaderSize(root.size());
+    for (JsonPairConst member : root) {
+        size_t keyLength = strlen(member.key().c_str());
+        size += packedStringHeaderSize(keyLength) + keyLength + measureIndexedValue(member.value());
+    }
+    return size;
+}
+
+// Writes the big-endian length of a MessagePack string or map after its type byte.
+size_t writePackedHeader(Print& out, uint8_t type, size_t lengthSize, size_t length) {
+    uint8_t raw[5] = {type};
+    for (size_t i = 0; i < lengthSize; ++i) {
+        raw[1 + i] = static_cast<uint8_t>(length >> (8 * (lengthSize - 1 - i)));
+    }
+    return out.write(raw, 1 + lengthSize);
+}
+
+size_t writePackedString(Print& out, const char* text, size_t length) {
+    size_t written;
+    if (length < 32) {
+        written = writePackedHeader(out, 0xa0 | length, 0, 0);
+    } else if (length < 256) {
+        written = writePackedHeader(out, 0xd9, 1, length);
+    } else if (length < 65536) {
+        written = writePackedHeader(out, 0xda, 2, length);
+    } else {
+        written = writePackedHeader(out, 0xdb, 4, length);
+    }
+    return written + out.write(reinterpret_cast<const uint8_t*>(text), length);
+}
+
+size_t writePackedMapHeader(Print& out, size_t count) {
+    if (count < 16) {
+        return writePackedHeader(out, 0x80 | count, 0, 0);
+    }
+    return count < 65536 ? writePackedHeader(out, 0xde, 2, count) : writePackedHeader(out, 0xdf, 4, count);
+}
+
+size_t writeIndexedValue(Print& out, JsonVariantConst value) {
+    uint8_t raw[5];
+    if (value.is<int32_t>()) {
+        raw[0] = PackedInt;
+        putBE32(raw + 1, static_cast<uint32_t>(value.as<int32_t>()));
+    } else if (isFloat(value)) {
+        float number = value.as<float>();
+        uint32_t bits;
+        memcpy(&bits, &number, sizeof(bits));
+        raw[0] = PackedFloat;
+        putBE32(raw + 1, bits);
+    } else {
+        return serializeMsgPack(value, out);
+    }
+    return out.write(raw, sizeof(raw));
+}
+
+struct IndexedMember {
+    uint32_t hash;
+    const char* key;
+    JsonVariantConst value;
+};
+
+size_t serializeIndexed(JsonObjectConst root, Print& out) {
+    std::vector<IndexedMember> members;
+    members.reserve(root.size());
+    for (JsonPairConst member : root) {
+        members.push_back({hashKey(member.key().c_str()), member.key().c_str(), member.value()});
+    }
+    std::sort(members.begin(), members.end(), [](const IndexedMember& a, const IndexedMember& b) {
+        return a.hash != b.hash ? a.hash < b.hash : strcmp(a.key, b.key) < 0;
+    });
+    uint8_t raw[IndexPreambleSize] = {IndexMagic[0], IndexMagic[1], IndexVersion, 0};
+    putU32(raw + 4, members.size());
+    size_t written = out.write(raw, IndexPreambleSize);
+    size_t offset = IndexPreambleSize + members.size() * IndexEntrySize + packedMapHeaderSize(members.size());
+    for (const IndexedMember& member : members) {
+        putU32(raw, member.hash);
+        putU32(raw + 4, offset);
+        written += out.write(raw, IndexEntrySize);
+        size_t keyLength = strlen(member.key);
+        offset += packedStringHeaderSize(keyLength) + keyLength + measureIndexedValue(member.value);
+    }
+    written += writePackedMapHeader(out, members.size());
+    for (const IndexedMember& member : members) {
+        written += writePackedString(out, member.key, strlen(member.key));
+        written += writeIndexedValue(out, member.value);
+    }
+    return written;
+}
+
+// Reads the preamble and the index, so that the members can be parsed as MessagePack. False if the stream is not indexed.
+bool skipIndex(Stream& in) {
+    uint8_t raw[IndexPreambleSize];
+    if (in.readBytes(reinterpret_cast<char*>(raw), sizeof(raw)) != sizeof(raw) || raw[0] != IndexMagic[0] ||
+        raw[1] != IndexMagic[1] || raw[2] != IndexVersion) {
+        return false;
+    }
+    size_t remaining = getU32(raw + 4) * IndexEntrySize;
+    char buffer[32];
+    while (remaining > 0) {
+        size_t count = in.readBytes(buffer, remaining < sizeof(buffer) ? remaining : sizeof(buffer));
+        if (count == 0) {
+            return false;
+        }
+        remaining -= count;
+    }
+    return true;
+}
+
+// Looks up members of an indexed file with a binary search over its index, using seeks and small reads.
+class IndexReader {
+public:
+    explicit IndexReader(File& file) : file(file) {}
+
+    // Finds a key and leaves the file at its value. Returns false if the file cannot be searched.
+    bool find(const char* key, uint32_t hash, bool& found) {
+        uint8_t raw[IndexPreambleSize];
+        if (!readAt(0, raw, sizeof(raw)) || raw[0] != IndexMagic[0] || raw[1] != IndexMagic[1] || raw[2] != IndexVersion) {
+            return false;
+        }
+        uint32_t count = getU32(raw + 4);
+        uint32_t low = 0;
+        uint32_t high = count;
+        while (low < high) {
+            uint32_t middle = low + (high - low) / 2;
+            if (!readAt(IndexPreambleSize + middle * IndexEntrySize, raw, IndexEntrySize)) {
+                return false;
+            }
+            if (getU32(raw) < hash) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        size_t keyLength = strlen(key);
+        found = false;
+        // Keys with the same hash are next to each other
+        for (; low < count; ++low) {
+            if (!readAt(IndexPreambleSize + low * IndexEntrySize, raw, IndexEntrySize)) {
+                return false;
+            }
+            if (getU32(raw) != hash) {
+                return true;
+            }
+            size_t length;
+            if (!file.seek(getU32(raw + 4)) || !readStringHeader(length)) {
+                return false;
+            }
+            if (length == keyLength && matches(key, keyLength)) {
+                found = true;
+                return true;
+            }
+        }
+        return true;
+    }
+
+    // Reads the type byte of a value, or of a MessagePack string header.
+    bool readType(uint8_t& type) {
+        return read(&type, 1);
+    }
+
+    bool readBE32(uint32_t& value) {
+        uint8_t raw[4];
+        if (!read(raw, sizeof(raw))) {
+            return false;
+        }
+        value = getBE(raw, sizeof(raw));
+        return true;
+    }
+
+    // Reads the length following the type byte of a string. False if type is not a string.
+    bool readStringLength(uint8_t type, size_t& length) {
+        if ((type & 0xe0) == 0xa0) {
+            length = type & 0x1f;
+            return true;
+        }
+        size_t size = type == 0xd9 ? 1 : (type == 0xda ? 2 : (type == 0xdb ? 4 : 0));
+        uint8_t raw[4];
+        if (size == 0 || !read(raw, size)) {
+            return false;
+        }
+        length = getBE(raw, size);
+        return true;
+    }
+
+    bool read(uint8_t* buffer, size_t length) {
+        size_t count = file.read(buffer, length);
+        bytesRead += count;
+        return count == length;
+    }
+
+    size_t bytesRead = 0;
+
+private:
+    bool readAt(uint32_t position, uint8_t* buffer, size_t length) {
+        return file.seek(position) && read(buffer, length);
+    }
+
+    bool readStringHeader(size_t& length) {
+        uint8_t type;
+        return readType(type) && readStringLength(type, length);
+    }
+
+    bool matches(const char* key, size_t length) {
+        uint8_t chunk[32];
+        while (length > 0) {
+            size_t count = length < sizeof(chunk) ? length : sizeof(chunk);
+            if (!read(chunk, count) || memcmp(chunk, key, count) != 0) {
+                return false;
+            }
+            key += count;
+            length -= count;
+        }
+        return true;
+    }
+
+    File& file;
+};
+
+} // namespace
+
+/**
+ * @brief Computes the CRC-32 (as used by zlib and Ethernet) of a block of bytes.
+ * @param data The bytes.
+ * @param length Number of bytes.
+ * @param crc The CRC of the preceding bytes, to continue a calculation, or 0.
+ * @return The CRC of all bytes so far.
+ * 
+ * One table lookup per byte; the 1 KB table is kept in flash.
+ */
+uint32_t tinyConfigCrc32(const uint8_t* data, size_t length, uint32_t crc) {
+    crc = ~crc;
+    while (length--) {
+        crc = pgm_read_dword(&crcTable[(crc ^ *data++) & 0xff]) ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+/**
+ * @brief Creates a configuration namespace.
+ * @param name The namespace, used as the base name of its files. The default namespace "config" is stored in /config.json.
+ * 
+ * Every namespace is backed by its own files (/<name>.json, /<name>.msgpack, /<name>.log, ...), so a write only
+ * rewrites the file of its namespace and a namespace that is never started is never read. Each instance has its own
+ * settings, cache and statistics. Use a name of at most 22 characters without '/', so the longest file name still
+ * fits the 31 characters LittleFS allows; two instances with the same name share their files and must not run at the
+ * same time.
+ */
+TinyConfig::TinyConfig(const char* name) {
+    String base = "/";
+    base += name;
+    FileString = base + ".json";
+    MsgPackFileString = base + ".msgpack";
+    IndexFileString = base + ".idx";
+    LogFileString = base + ".log";
+    SnapshotTempString = base + ".tmp";
+    SlotFileStrings[0] = base + ".a";
+    SlotFileStrings[1] = base + ".b";
+}
+
 /**
  * @brief Initializes the TinyConfig system and filesystem.
  * @return true if initialization succeeded, false otherwise.
  * 
- * This function mounts the LittleFS filesystem and checks if the configuration file exists.
+ * This function mounts the LittleFS filesystem, unless another instance already did, and checks if the configuration file exists.
  * If the file does not exist, it attempts to create a new configuration file with an empty JSON object.
+ * If only a file in the other storage format exists, it is converted to the format set with setFormat().
+ * If cache mode, write-back mode or log mode is enabled, the configuration is parsed once here and kept in RAM.
+ * In log mode this replays the log on top of the last snapshot.
+ * If the configuration cannot be loaded there, for example because the file is corrupt, StartTC() fails and
+ * getLastError() tells why; the file can then be replaced with resetConfig() before retrying.
  * If the filesystem is already initialized, check getLastError() or getLastErrorString() for details.
  * If the filesystem cannot be mounted, check getLastError() or getLastErrorString() for details.
  */
@@ -20,26 +663,54 @@ bool TinyConfig::StartTC() {
         lastError = TinyConfigError::FSAlreadyRunning;
         return false;
     }
-    if (!LittleFS.begin()) {
+    if (mountCount == 0 && !LittleFS.begin()) {
         lastError = TinyConfigError::FSInitFailed;
         return false;
     }
-    if (!LittleFS.exists(FileString)) {
-        if (!resetConfig()) {
-            lastError = TinyConfigError::FileCreateFailed;
-            return false;
+    ++mountCount;
+    if (!openConfig()) {
+        if (--mountCount == 0) {
+            LittleFS.end();
         }
+        return false;
     }
+    ++generation; // the file may have been changed while TinyConfig was stopped
     lastError = TinyConfigError::None;
     isInitialized = true;
     return true;
 }
 
+/**
+ * @brief Prepares the configuration file for StartTC().
+ * @return true if the configuration can be used, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * Migrates the file to the current storage, checks its CRC and, if a document is kept in RAM, loads it.
+ */
+bool TinyConfig::openConfig() {
+    if (!migrateSlots()) {
+        return false;
+    }
+    if (!atomicSave && !isResident() && !verifyConfig()) {
+        return false; // a resident document checks the CRC while it is parsed below
+    }
+    if (isResident()) {
+        cacheValid = false;
+        dirty = false;
+        std::unique_ptr<DynamicJsonDocument> scratch;
+        if (!openDoc(scratch)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 /**
  * @brief Stops the TinyConfig system and unmounts the filesystem.
  * @return true if stopped successfully, false otherwise.
  * 
- * This function unmounts the LittleFS filesystem and sets the initialized flag to false.
+ * This function unmounts the LittleFS filesystem, once no other instance is running, and sets the initialized flag to false.
+ * Uncommitted changes from write-back mode are committed first; if that fails, TinyConfig keeps running.
+ * The cached document, if any, is released.
  * If the system is not initialized. On failure, check getLastError() or getLastErrorString() for details.
  */
 bool TinyConfig::StopTC() {
@@ -47,7 +718,15 @@ bool TinyConfig::StopTC() {
         lastError = TinyConfigError::FSNotRunning;
         return false;
     }
-    LittleFS.end();
+    if (!commit()) {
+        return false;
+    }
+    cacheDoc.reset();
+    cacheValid = false;
+    parseDoc.reset();
+    if (--mountCount == 0) {
+        LittleFS.end();
+    }
     isInitialized = false;
     lastError = TinyConfigError::None;
     return true;
@@ -58,17 +737,52 @@ bool TinyConfig::StopTC() {
  * @return true if reset succeeded, false otherwise.
  * 
  * This function opens the configuration file in write mode and clears its contents.
+ * The cached document, if any, is cleared as well and uncommitted changes are discarded.
+ * Every onChange() handler is called with a null value.
+ * In log mode the log is removed first, so its records cannot be replayed on top of the empty configuration.
  * If the file cannot be created or opened, check getLastError() or getLastErrorString() for details.
- * If the filesystem is not initialized. On failure, check getLastError() or getLastErrorString() for details.
+ * If no instance is running, for example after StartTC() failed, the filesystem is mounted for the reset only.
  */
 bool TinyConfig::resetConfig() {
-    File file = LittleFS.open(FileString, "w");
-    if (!file) {
+    bool ownMount = mountCount == 0;
+    if (ownMount && !LittleFS.begin()) {
+        lastError = TinyConfigError::FSInitFailed;
+        return false;
+    }
+    bool reset = resetFiles();
+    if (ownMount) {
+        LittleFS.end();
+    }
+    return reset;
+}
+
+/**
+ * @brief Writes the empty configuration for resetConfig().
+ * @return true if reset succeeded, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ */
+bool TinyConfig::resetFiles() {
+    if (logMode) {
+        LittleFS.remove(LogFileString.c_str());
+        LittleFS.remove(SnapshotTempString.c_str());
+        logBytes = 0;
+    }
+    StaticJsonDocument<16> empty;
+    empty.to<JsonObject>();
+    if (atomicSave ? !writeSlot(empty) : !writeDoc(empty, configPath(format), fileHeader)) {
         lastError = TinyConfigError::FileCreateFailed;
         return false;
     }
-    file.print("{}");
-    file.close();
+    if (JsonDocument* cached = cachedDoc()) {
+        cached->clear();
+        cached->to<JsonObject>();
+        cacheValid = true;
+        cacheBytes = 0;
+    }
+    ++generation;
+    dirty = false;
+    if (isInitialized) {
+        notifyChanges(JsonObjectConst(), true);
+    }
     lastError = TinyConfigError::None;
     return true;
 }
@@ -90,6 +804,23 @@ String TinyConfig::getLastErrorString() const {
     return (it != TinyConfigErrorStrings.end()) ? it->second : "unknown error";
 }
 
+/**
+ * @brief Gets the operation counters collected since start or the last resetStats().
+ * @return Reference to the counters. Useful to find code paths that read or write the configuration file too often.
+ * 
+ * Counters only grow; times are in microseconds and wrap around after about 71 minutes of accumulated time.
+ */
+const TinyConfigStats& TinyConfig::getStats() const {
+    return stats;
+}
+
+/**
+ * @brief Resets all operation counters to zero.
+ */
+void TinyConfig::resetStats() {
+    stats = TinyConfigStats();
+}
+
 /**
  * @brief Sets the maximum allowed file size for the configuration file.
  * @param maxSize The maximum file size in bytes. If the config exceeds this size, set operations will fail.
@@ -99,6 +830,8 @@ String TinyConfig::getLastErrorString() const {
  * If the provided size is less than 9 bytes or greater than 4096 bytes, it sets the lastError to FileSizeToSmall or FileSizeTooLarge respectively.
  * If the size is valid, it updates maxFileSize and sets lastError to None.
  * Changing the maximum file size affects all subsequent set operations. It does not change the size of the existing file.
+ * In cache mode the cached document is dropped and parsed again with the new size on the next access.
+ * In write-back mode uncommitted changes are committed first.
  */
 bool TinyConfig::setMaxFileSize(size_t maxSize) {
     if (maxSize < 9) {
@@ -109,92 +842,1839 @@ bool TinyConfig::setMaxFileSize(size_t maxSize) {
         lastError = TinyConfigError::FileSizeTooLarge;
         return false;
     }
+    if (maxSize != maxFileSize) {
+        if (dirty && !commit()) {
+            return false;
+        }
+        cacheDoc.reset();
+        cacheValid = false;
+        parseDoc.reset();
+    }
     maxFileSize = maxSize;
     lastError = TinyConfigError::None;
     return true;
 }
 
 /**
- * @brief Loads the configuration file into a DynamicJsonDocument.
- * @param doc Reference to the DynamicJsonDocument to load into.
- * @return true if loading succeeded, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * @brief Enables or disables cache mode.
+ * @param enabled true to keep the parsed configuration in RAM, false to read the file on every call.
+ * @return true if the mode was changed successfully, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
  * 
- * This function opens the configuration file in read mode and attempts to deserialize its contents into the provided DynamicJsonDocument.
- * If the file cannot be opened or read, or if the JSON parsing fails, it sets the lastError accordingly.
- * If the filesystem is not initialized, it sets the lastError to FSNotRunning.
- * If the file is successfully loaded, it sets lastError to None.
+ * In cache mode the configuration file is parsed once (in StartTC(), or right away if TinyConfig is already running)
+ * and all getters are served from the document kept in RAM. The cached document is only updated by TinyConfig's
+ * own set, delete and reset operations, so changes made to the file by other code are not seen until cache mode
+ * is re-enabled or TinyConfig is restarted.
+ * The cache costs maxFileSize bytes of heap for as long as it is enabled.
+ * While write-back mode holds uncommitted changes, the document in RAM is kept as it is.
  */
-bool TinyConfig::loadDoc(DynamicJsonDocument& doc) {
-    File f = LittleFS.open(FileString, "r");
-    if (!f) {
-        lastError = TinyConfigError::FileOpenFailed;
-        return false;
+bool TinyConfig::setCacheMode(bool enabled) {
+    cacheEnabled = enabled;
+    if (!dirty) {
+        cacheDoc.reset();
+        cacheValid = false;
     }
-    auto err = deserializeJson(doc, f);
-    f.close();
-    if (err) {
-        lastError = TinyConfigError::JsonParseFailed;
-        return false;
+    if (isResident() && isInitialized) {
+        std::unique_ptr<DynamicJsonDocument> scratch;
+        if (!openDoc(scratch)) {
+            return false;
+        }
     }
     lastError = TinyConfigError::None;
     return true;
 }
 
 /**
- * @brief Saves a DynamicJsonDocument to the configuration file.
- * @param doc The DynamicJsonDocument to save.
- * @return true if saving succeeded, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * @brief Enables or disables reuse of the parse buffer.
+ * @param enabled true to keep the parse buffer allocated between calls, false to allocate it for every call.
+ * @return Always true.
  * 
- * This function opens the configuration file in write mode and serializes the provided DynamicJsonDocument to it.
- * If the file cannot be opened or written to, it sets the lastError accordingly.
+ * Outside of cache, write-back and log mode every call parses the configuration file into a document of maxFileSize
+ * bytes. Normally this document is allocated and freed by every call, which fragments the heap over a long uptime.
+ * With reuse enabled it is allocated once and kept, costing maxFileSize bytes of heap like cache mode does; unlike
+ * cache mode the file is still read on every call, so changes made by other code are seen.
  */
-bool TinyConfig::saveDoc(const DynamicJsonDocument& doc) {
-    File f = LittleFS.open(FileString, "w");
-    if (!f) {
-        lastError = TinyConfigError::FileOpenFailed;
-        return false;
-    }
-    if (serializeJson(doc, f) == 0) {
-        lastError = TinyConfigError::FileWriteFailed;
-        f.close();
-        return false;
+bool TinyConfig::setReuseParseBuffer(bool enabled) {
+    reuseParseBuffer = enabled;
+    if (!enabled) {
+        parseDoc.reset();
     }
-    f.close();
     lastError = TinyConfigError::None;
     return true;
 }
 
+/**
+ * @brief Enables or disables write-back mode.
+ * @param enabled true to buffer changes in RAM until commit(), false to write every change to the file immediately.
+ * @return true if the mode was changed successfully, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * In write-back mode set(), deleteKey() and deleteKeys() only modify the document kept in RAM and mark it dirty.
+ * The file is written once by commit(), by tick() after the flush delay (see setFlushDelay()), or automatically by
+ * StopTC(). Getters always see the pending changes.
+ * Disabling write-back mode commits pending changes first and turns the flush delay off.
+ * Like cache mode, write-back mode costs maxFileSize bytes of heap while it is enabled.
+ */
+bool TinyConfig::setWriteBack(bool enabled) {
+    if (!enabled && dirty && !commit()) {
+        return false;
+    }
+    writeBack = enabled;
+    if (!writeBack) {
+        flushDelay = 0;
+    }
+    if (!writeBack && !cacheEnabled) {
+        cacheDoc.reset();
+        cacheValid = false;
+    }
+    if (writeBack && isInitialized) {
+        std::unique_ptr<DynamicJsonDocument> scratch;
+        if (!openDoc(scratch)) {
+            return false;
+        }
+    }
+    lastError = TinyConfigError::None;
+    return true;
+}
+
+/**
+ * @brief Writes changes buffered in write-back mode to the configuration file.
+ * @return true if there was nothing to write or the file was written, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * If the file cannot be written, the changes stay pending and commit() can be called again.
+ */
+bool TinyConfig::commit() {
+    if (!isInitialized) {
+        lastError = TinyConfigError::FSNotRunning;
+        return false;
+    }
+    if (dirty) {
+        if (!saveDoc(*cachedDoc())) {
+            return false;
+        }
+        dirty = false;
+    }
+    lastError = TinyConfigError::None;
+    return true;
+}
+
+/**
+ * @brief Checks whether write-back mode holds changes that are not in the file yet.
+ * @return true if commit() would write to the file, false otherwise.
+ */
+bool TinyConfig::isDirty() const {
+    return dirty;
+}
+
+/**
+ * @brief Sets the quiet period after which tick() writes buffered changes.
+ * @param ms Milliseconds without a change before the changes are written, or 0 to write only on commit().
+ * @return true if the delay was set, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * A delay enables write-back mode, so a burst of set() calls, e.g. from a slider or rotary encoder, only changes
+ * the document in RAM. Once the configuration has not changed for ms milliseconds, the next tick() writes it with a
+ * single flash write. As long as changes keep coming, the write is postponed. Setting the delay to 0 leaves
+ * write-back mode enabled; disable it with setWriteBack(false).
+ */
+bool TinyConfig::setFlushDelay(uint32_t ms) {
+    if (ms > 0 && !writeBack && !setWriteBack(true)) {
+        return false;
+    }
+    flushDelay = ms;
+    lastError = TinyConfigError::None;
+    return true;
+}
+
+/**
+ * @brief Writes buffered changes once the flush delay has passed. Call it from loop().
+ * @return true if there was nothing to write yet or the file was written, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * Without a flush delay or pending changes, this only compares a flag. If writing fails, the changes stay pending
+ * and the next tick() tries again.
+ */
+bool TinyConfig::tick() {
+    if (flushDelay == 0 || !dirty || !isInitialized || millis() - lastChangeMillis < flushDelay) {
+        lastError = TinyConfigError::None;
+        return true;
+    }
+    return commit();
+}
+
+/**
+ * @brief Writes buffered changes right away, without waiting for the flush delay.
+ * @return true if there was nothing to write or the file was written, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * Use it on shutdown paths, e.g. before a restart or deep sleep. It is the same as commit().
+ */
+bool TinyConfig::flushNow() {
+    return commit();
+}
+
+/**
+ * @brief Selects the storage format of the configuration file.
+ * @param newFormat TinyConfigFormat::Json (default, /config.json), TinyConfigFormat::MessagePack (/config.msgpack) or TinyConfigFormat::Indexed (/config.idx).
+ * @return true if the format was changed successfully, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * MessagePack files are smaller and faster to parse, especially with many numbers, but they are not human readable.
+ * Indexed files are MessagePack with an index of the key hashes in front, sorted for a binary search. Outside of cache,
+ * write-back and log mode, a getter seeks to the key and reads only the index entries it compares and the value,
+ * instead of parsing the file; set() of an int or float key that already holds a value of the same type overwrites
+ * its 4 bytes in place. This pays off for configurations with hundreds of keys. Floats are stored with float precision.
+ * Set the format before StartTC(); StartTC() converts an existing file of the other format. If TinyConfig is already
+ * running, the configuration is written in the new format right away and the old file is removed.
+ * maxFileSize applies to the file in the selected format. Getters, getAll() and the log of log mode are not affected.
+ */
+bool TinyConfig::setFormat(TinyConfigFormat newFormat) {
+    if (newFormat == format) {
+        lastError = TinyConfigError::None;
+        return true;
+    }
+    if (!isInitialized) {
+        format = newFormat;
+        cacheBytes = 0;
+        lastError = TinyConfigError::None;
+        return true;
+    }
+    std::unique_ptr<DynamicJsonDocument> scratch;
+    JsonDocument* doc = openDoc(scratch);
+    if (!doc) {
+        return false;
+    }
+    TinyConfigFormat oldFormat = format;
+    format = newFormat;
+    if (!saveDoc(*doc)) {
+        format = oldFormat;
+        cacheBytes = 0;
+        return false;
+    }
+    LittleFS.remove(configPath(oldFormat));
+    dirty = false;
+    lastError = TinyConfigError::None;
+    return true;
+}
+
+/**
+ * @brief Gets the storage format of the configuration file.
+ * @return The format selected with setFormat().
+ */
+TinyConfigFormat TinyConfig::getFormat() const {
+    return format;
+}
+
+/**
+ * @brief Enables or disables log mode.
+ * @param enabled true to append changes to a log file, false to rewrite the configuration file on every change.
+ * @return true if the mode was changed successfully, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * In log mode set(), deleteKey() and deleteKeys() append a small record to /config.log instead of rewriting
+ * /config.json, so their cost depends on the size of the change, not of the configuration. The configuration is kept
+ * in RAM and rebuilt on StartTC() by replaying the log on top of /config.json. Once the log is larger than the
+ * compact threshold, the configuration is written as a new snapshot and the log starts over.
+ * Transactions, commit() and resetConfig() always write a snapshot.
+ * Enable log mode before StartTC() on every boot; without it, records in the log are not seen.
+ * Disabling log mode while TinyConfig is running writes a snapshot first, so nothing is left in the log.
+ * Like cache mode, log mode costs maxFileSize bytes of heap while it is enabled.
+ */
+bool TinyConfig::setLogMode(bool enabled) {
+    if (enabled == logMode) {
+        lastError = TinyConfigError::None;
+        return true;
+    }
+    if (enabled) {
+        if (dirty && !commit()) {
+            return false;
+        }
+        logMode = true;
+        cacheDoc.reset();
+        cacheValid = false;
+        if (isInitialized) {
+            std::unique_ptr<DynamicJsonDocument> scratch;
+            if (!openDoc(scratch)) {
+                return false;
+            }
+        }
+    } else {
+        if (isInitialized && !compact()) {
+            return false;
+        }
+        logMode = false;
+        if (!isResident()) {
+            cacheDoc.reset();
+            cacheValid = false;
+        }
+    }
+    lastError = TinyConfigError::None;
+    return true;
+}
+
+/**
+ * @brief Sets the log size at which log mode writes a new snapshot.
+ * @param logSize The maximum log size in bytes before compaction.
+ * @return true if the threshold was set, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * A larger threshold means fewer snapshots, but a longer replay on StartTC(). The default is 2048 bytes.
+ */
+bool TinyConfig::setCompactThreshold(size_t logSize) {
+    if (logSize == 0) {
+        lastError = TinyConfigError::FileSizeTooSmall;
+        return false;
+    }
+    compactThreshold = logSize;
+    lastError = TinyConfigError::None;
+    return true;
+}
+
+/**
+ * @brief Writes the configuration as a new snapshot and empties the log.
+ * @return true if the snapshot was written or log mode is off, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * Changes buffered in write-back mode are part of the snapshot, so they are committed as well.
+ */
+bool TinyConfig::compact() {
+    if (!isInitialized) {
+        lastError = TinyConfigError::FSNotRunning;
+        return false;
+    }
+    if (!logMode) {
+        lastError = TinyConfigError::None;
+        return true;
+    }
+    std::unique_ptr<DynamicJsonDocument> scratch;
+    JsonDocument* doc = openDoc(scratch);
+    if (!doc || !saveDoc(*doc)) {
+        return false;
+    }
+    dirty = false;
+    lastError = TinyConfigError::None;
+    return true;
+}
+
+/**
+ * @brief Enables or disables atomic save mode.
+ * @param enabled true to keep two copies of the configuration and write them in turns, false to use a single file.
+ * @return true if the mode was changed successfully, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * Writing a file truncates it first, so a reset or power loss while the configuration file is written leaves an
+ * empty or partial file behind. In atomic save mode the configuration is stored in /config.a and /config.b instead.
+ * Each copy starts with a small header holding a generation number, the length and a checksum of the document, and
+ * every save overwrites the older copy with the next generation. StartTC() reads both headers and uses the newest
+ * complete copy; if its checksum does not match when it is loaded, the other copy is used.
+ * Enable atomic save mode before StartTC() on every boot; StartTC() moves an existing configuration file into the
+ * copies, or back into the configuration file if the mode is off. If TinyConfig is already running, the configuration
+ * is moved right away.
+ */
+bool TinyConfig::setAtomicSave(bool enabled) {
+    if (enabled == atomicSave) {
+        lastError = TinyConfigError::None;
+        return true;
+    }
+    if (!isInitialized) {
+        atomicSave = enabled;
+        lastError = TinyConfigError::None;
+        return true;
+    }
+    std::unique_ptr<DynamicJsonDocument> scratch;
+    JsonDocument* doc = openDoc(scratch);
+    if (!doc) {
+        return false;
+    }
+    atomicSave = enabled;
+    if (enabled) {
+        selectSlot();
+    }
+    if (!saveDoc(*doc)) {
+        atomicSave = !enabled;
+        return false;
+    }
+    if (enabled) {
+        removeConfigFiles(false);
+    } else {
+        LittleFS.remove(SlotFileStrings[0].c_str());
+        LittleFS.remove(SlotFileStrings[1].c_str());
+    }
+    dirty = false;
+    lastError = TinyConfigError::None;
+    return true;
+}
+
+/**
+ * @brief Enables or disables the header of the configuration file.
+ * @param enabled true to write a header in front of the document, false to write the document only.
+ * @return true if the setting was changed successfully, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * The 16 byte header holds a magic number, a format version, the storage format, the length and a CRC32 of the
+ * document. StartTC() detects a corrupted configuration file that has a header with a quick CRC pass over the file
+ * instead of a failed parse, or while parsing in cache mode, and fails with ChecksumMismatch; call resetConfig() to
+ * start over. Every load checks the CRC as well, while parsing. Files are read with or without a header regardless of this setting; the
+ * setting decides how the file is written. If TinyConfig is already running, the file is rewritten right away.
+ * The copies of atomic save mode always have a header. getAll(Print&) cannot copy a file with a header unparsed.
+ */
+bool TinyConfig::setFileHeader(bool enabled) {
+    if (enabled == fileHeader) {
+        lastError = TinyConfigError::None;
+        return true;
+    }
+    fileHeader = enabled;
+    if (!isInitialized || atomicSave) {
+        lastError = TinyConfigError::None;
+        return true;
+    }
+    std::unique_ptr<DynamicJsonDocument> scratch;
+    JsonDocument* doc = openDoc(scratch);
+    if (!doc || !saveDoc(*doc)) {
+        fileHeader = !enabled;
+        return false;
+    }
+    dirty = false;
+    lastError = TinyConfigError::None;
+    return true;
+}
+
+/**
+ * @brief Checks whether the configuration is kept in RAM between calls.
+ * @return true in cache mode, write-back mode and log mode and for TinyConfigStatic, false otherwise.
+ */
+bool TinyConfig::isResident() const {
+    return cacheEnabled || writeBack || logMode || staticDoc;
+}
+
+/**
+ * @brief Gets the document the configuration is kept in between calls.
+ * @return The document inside TinyConfigStatic, the cached document, or nullptr if none is allocated.
+ */
+JsonDocument* TinyConfig::cachedDoc() const {
+    return staticDoc ? staticDoc : cacheDoc.get();
+}
+
+/**
+ * @brief Keeps the configuration in a document owned by a derived class instead of the heap.
+ * @param document The document, which must live as long as this instance.
+ * 
+ * Called by TinyConfigStatic before the instance is started.
+ */
+void TinyConfig::useStaticDoc(JsonDocument& document) {
+    staticDoc = &document;
+}
+
+/**
+ * @brief Frees the memory of replaced strings in a document's pool.
+ * @param doc The document to compact.
+ * @return false if the document could not be parsed again, true otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * A DynamicJsonDocument is copied into a fresh pool on the heap. The document of TinyConfigStatic is parsed again
+ * from the file instead, which needs no memory besides the document itself; while it holds changes that are not
+ * in the file, in write-back and log mode, it is left as it is.
+ */
+bool TinyConfig::compactDoc(JsonDocument& doc) {
+    if (&doc != staticDoc) {
+        static_cast<DynamicJsonDocument&>(doc).garbageCollect();
+        if (&doc == cachedDoc()) {
+            ++generation; // remembered lookups point into the old pool
+        }
+        return true;
+    }
+    if (dirty || logMode || !cacheValid) {
+        return true;
+    }
+    ++generation;
+    if (!loadDoc(doc)) {
+        cacheValid = false;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Gets the path of the configuration file for a storage format.
+ * @param fileFormat The storage format.
+ * @return /<name>.json for JSON, /<name>.msgpack for MessagePack, /<name>.idx for Indexed.
+ */
+const char* TinyConfig::configPath(TinyConfigFormat fileFormat) const {
+    switch (fileFormat) {
+        case TinyConfigFormat::MessagePack:
+            return MsgPackFileString.c_str();
+        case TinyConfigFormat::Indexed:
+            return IndexFileString.c_str();
+        default:
+            return FileString.c_str();
+    }
+}
+
+/**
+ * @brief Computes the size of a value in the current storage format without serializing it.
+ * @param value The value or document to measure.
+ * @return The size in bytes.
+ */
+size_t TinyConfig::measureDoc(JsonVariantConst value) const {
+    switch (format) {
+        case TinyConfigFormat::MessagePack:
+            return measureMsgPack(value);
+        case TinyConfigFormat::Indexed:
+            return measureIndexed(value.as<JsonObjectConst>());
+        default:
+            return measureJson(value);
+    }
+}
+
+/**
+ * @brief Computes the size of a member's value in the current storage format without serializing it.
+ * @param value The value to measure.
+ * @return The size in bytes.
+ * 
+ * Unlike measureDoc(), an object is measured as a value of the document, not as a whole document.
+ */
+size_t TinyConfig::measureValue(JsonVariantConst value) const {
+    return format == TinyConfigFormat::Indexed ? measureIndexedValue(value) : measureDoc(value);
+}
+
+/**
+ * @brief Serializes a document in the current storage format.
+ * @param doc The document to serialize.
+ * @param out Where to write the document.
+ * @return The number of bytes written.
+ */
+size_t TinyConfig::serializeDoc(const JsonDocument& doc, Print& out) const {
+    switch (format) {
+        case TinyConfigFormat::MessagePack:
+            return serializeMsgPack(doc, out);
+        case TinyConfigFormat::Indexed:
+            return serializeIndexed(doc.as<JsonObjectConst>(), out);
+        default:
+            return serializeJson(doc, out);
+    }
+}
+
+/**
+ * @brief Parses a document in the given storage format.
+ * @param doc The document to parse into.
+ * @param in The stream to read from.
+ * @param fileFormat The storage format of the stream.
+ * @param filter If not nullptr, only the members marked true in this document are kept.
+ * @return The result of the parser.
+ * 
+ * The index of an indexed file is skipped; its members are parsed as MessagePack.
+ */
+DeserializationError TinyConfig::deserializeDoc(JsonDocument& doc, Stream& in, TinyConfigFormat fileFormat, const JsonDocument* filter) const {
+    if (fileFormat == TinyConfigFormat::Indexed && !skipIndex(in)) {
+        return DeserializationError::InvalidInput;
+    }
+    bool packed = fileFormat != TinyConfigFormat::Json;
+    if (filter) {
+        DeserializationOption::Filter option(*filter);
+        return packed ? deserializeMsgPack(doc, in, option) : deserializeJson(doc, in, option);
+    }
+    return packed ? deserializeMsgPack(doc, in) : deserializeJson(doc, in);
+}
+
+/**
+ * @brief Makes sure the configuration file exists in the current storage format.
+ * @return true if the file exists or was created, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * If only a file of another format exists, it is converted: the document is written to a temporary file, which is
+ * renamed over the new file before the old file is removed. An interrupted conversion is repeated on the next start.
+ * Leftover files of other formats next to the current one are removed, so they cannot be picked up by a later
+ * format change. If no file exists, an empty configuration is created.
+ */
+bool TinyConfig::migrateConfig() {
+    if (LittleFS.exists(configPath(format))) {
+        removeConfigFiles(true);
+        return true;
+    }
+    const TinyConfigFormat formats[] = {TinyConfigFormat::Json, TinyConfigFormat::MessagePack, TinyConfigFormat::Indexed};
+    TinyConfigFormat otherFormat = format;
+    for (TinyConfigFormat candidate : formats) {
+        if (candidate != format && LittleFS.exists(configPath(candidate))) {
+            otherFormat = candidate;
+            break;
+        }
+    }
+    if (otherFormat == format) {
+        if (!resetConfig()) {
+            lastError = TinyConfigError::FileCreateFailed;
+            return false;
+        }
+        return true;
+    }
+    const char* otherPath = configPath(otherFormat);
+    DynamicJsonDocument doc(maxFileSize);
+    File f = openFile(otherPath, "r");
+    if (!f) {
+        lastError = TinyConfigError::FileOpenFailed;
+        return false;
+    }
+    bool loaded = parseFile(f, doc, otherFormat);
+    closeFile(f);
+    if (!loaded) {
+        return false;
+    }
+    if (!writeDoc(doc, SnapshotTempString.c_str(), fileHeader)) {
+        LittleFS.remove(SnapshotTempString.c_str());
+        return false;
+    }
+    if (!LittleFS.rename(SnapshotTempString.c_str(), configPath(format))) {
+        lastError = TinyConfigError::FileWriteFailed;
+        return false;
+    }
+    removeConfigFiles(true);
+    return true;
+}
+
+/**
+ * @brief Removes the configuration files of all storage formats.
+ * @param keepCurrent true to keep the file of the current format.
+ */
+void TinyConfig::removeConfigFiles(bool keepCurrent) {
+    const TinyConfigFormat formats[] = {TinyConfigFormat::Json, TinyConfigFormat::MessagePack, TinyConfigFormat::Indexed};
+    for (TinyConfigFormat candidate : formats) {
+        if ((!keepCurrent || candidate != format) && LittleFS.exists(configPath(candidate))) {
+            LittleFS.remove(configPath(candidate));
+        }
+    }
+}
+
+/**
+ * @brief Makes sure the configuration is stored the way atomic save mode requires.
+ * @return true if the configuration exists or was created, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * In atomic save mode an existing configuration file is written into the first copy and then removed; without atomic
+ * save mode the newest copy is written to the configuration file before both copies are removed. An interrupted move
+ * is repeated on the next start. Otherwise this is migrateConfig().
+ */
+bool TinyConfig::migrateSlots() {
+    bool hasSlot = selectSlot();
+    if (atomicSave && hasSlot) {
+        removeConfigFiles(false);
+        return true;
+    }
+    if (!atomicSave && !hasSlot) {
+        return migrateConfig();
+    }
+    DynamicJsonDocument doc(maxFileSize);
+    if (atomicSave) {
+        atomicSave = false;
+        bool loaded = migrateConfig() && loadDoc(doc);
+        atomicSave = true;
+        if (!loaded || !writeSlot(doc)) {
+            return false;
+        }
+        LittleFS.remove(configPath(format));
+        return true;
+    }
+    if (!loadSlot(doc)) {
+        return false;
+    }
+    if (!writeDoc(doc, SnapshotTempString.c_str(), fileHeader)) {
+        LittleFS.remove(SnapshotTempString.c_str());
+        return false;
+    }
+    if (!LittleFS.rename(SnapshotTempString.c_str(), configPath(format))) {
+        lastError = TinyConfigError::FileWriteFailed;
+        return false;
+    }
+    LittleFS.remove(SlotFileStrings[0].c_str());
+    LittleFS.remove(SlotFileStrings[1].c_str());
+    return migrateConfig();
+}
+
+/**
+ * @brief Finds the newest complete copy of the configuration in atomic save mode.
+ * @return true if a copy was found, false if neither copy is complete.
+ * 
+ * Only the headers are read. If this instance ran before and its last copy is still complete with the same generation,
+ * only that header is read; otherwise both are. The CRC is checked when the copy is loaded, and loadSlot() falls back
+ * to the other copy if it does not match. If no copy is found, the next save writes the first copy with generation 1.
+ */
+bool TinyConfig::selectSlot() {
+    FileHeader remembered;
+    if (slotGeneration != 0 && readSlotHeader(activeSlot, remembered) && remembered.generation == slotGeneration) {
+        return true;
+    }
+    FileHeader headers[2];
+    bool valid[2] = {readSlotHeader(0, headers[0]), readSlotHeader(1, headers[1])};
+    if (!valid[0] && !valid[1]) {
+        activeSlot = 1;
+        slotGeneration = 0;
+        return false;
+    }
+    activeSlot = (valid[1] && (!valid[0] || headers[1].generation > headers[0].generation)) ? 1 : 0;
+    slotGeneration = headers[activeSlot].generation;
+    return true;
+}
+
+/**
+ * @brief Reads the header in front of a document.
+ * @param file The file, positioned at its start.
+ * @param header Receives the header.
+ * @return true if the file starts with a header and holds the complete document, false otherwise.
+ */
+bool TinyConfig::readFileHeader(File& file, FileHeader& header) {
+    uint8_t raw[FileHeaderSize];
+    if (file.read(raw, sizeof(raw)) != sizeof(raw) || raw[0] != FileMagic[0] || raw[1] != FileMagic[1] ||
+        raw[2] != FileHeaderVersion || raw[3] > static_cast<uint8_t>(TinyConfigFormat::Indexed)) {
+        return false;
+    }
+    header.format = raw[3];
+    header.generation = getU32(raw + 4);
+    header.length = getU32(raw + 8);
+    header.crc = getU32(raw + 12);
+    return file.size() == FileHeaderSize + header.length;
+}
+
+/**
+ * @brief Reads the header of a copy of the configuration.
+ * @param slot The copy to read, 0 or 1.
+ * @param header Receives the header.
+ * @return true if the header was read and the copy is complete, false otherwise.
+ */
+bool TinyConfig::readSlotHeader(uint8_t slot, FileHeader& header) {
+    if (!LittleFS.exists(SlotFileStrings[slot].c_str())) {
+        return false;
+    }
+    File f = openFile(SlotFileStrings[slot].c_str(), "r");
+    if (!f) {
+        return false;
+    }
+    bool valid = readFileHeader(f, header);
+    closeFile(f);
+    return valid;
+}
+
+/**
+ * @brief Parses a configuration file, with or without a header.
+ * @param file The file, positioned at its start.
+ * @param doc The document to parse into.
+ * @param fileFormat The storage format of a file without a header.
+ * @param filter If not nullptr, only the members marked true in this document are kept.
+ * @return true if the document was parsed and its CRC matches, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * A file starting with a header is parsed in the format recorded in the header, and the CRC is computed while the
+ * document is parsed, so no extra pass over the file is needed.
+ */
+bool TinyConfig::parseFile(File& file, JsonDocument& doc, TinyConfigFormat fileFormat, const JsonDocument* filter) {
+    stats.loadCount++;
+    uint32_t start = micros();
+    DeserializationError err;
+    bool intact = true;
+    if (file.peek() == FileMagic[0]) {
+        FileHeader header;
+        if (!readFileHeader(file, header)) {
+            lastError = TinyConfigError::ChecksumMismatch;
+            return false;
+        }
+        ChecksumReader in(file, header.length);
+        err = deserializeDoc(doc, in, static_cast<TinyConfigFormat>(header.format), filter);
+        intact = in.finish() && in.checksum == header.crc;
+        fileBytes = header.length;
+    } else {
+        err = deserializeDoc(doc, file, fileFormat, filter);
+        fileBytes = file.size();
+    }
+    addTiming(stats.parseMicros, stats.parseMaxMicros, start);
+    stats.bytesParsed += file.position();
+    if (!intact) {
+        lastError = TinyConfigError::ChecksumMismatch;
+        return false;
+    }
+    if (err) {
+        lastError = TinyConfigError::JsonParseFailed;
+        return false;
+    }
+    lastError = TinyConfigError::None;
+    return true;
+}
+
+/**
+ * @brief Checks the CRC of the configuration file without parsing it.
+ * @return true if the file has no header or its CRC matches, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ */
+bool TinyConfig::verifyConfig() {
+    File f = openFile(configPath(format), "r");
+    if (!f) {
+        lastError = TinyConfigError::FileOpenFailed;
+        return false;
+    }
+    bool intact = true;
+    if (f.peek() == FileMagic[0]) {
+        FileHeader header;
+        intact = readFileHeader(f, header);
+        if (intact) {
+            ChecksumReader in(f, header.length);
+            intact = in.finish() && in.checksum == header.crc;
+        }
+    }
+    closeFile(f);
+    if (!intact) {
+        lastError = TinyConfigError::ChecksumMismatch;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Loads the active copy of the configuration in atomic save mode.
+ * @param doc Reference to the document to load into.
+ * @param filter If not nullptr, only the members marked true in this document are kept.
+ * @return true if loading succeeded, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * The CRC is computed while the document is parsed. If the copy is missing or its CRC does not match, the other copy
+ * is loaded instead and becomes the active one, so the next save overwrites the broken copy. A copy that is intact
+ * but does not fit into doc is not replaced by the older one.
+ */
+bool TinyConfig::loadSlot(JsonDocument& doc, const JsonDocument* filter) {
+    TinyConfigError failure = TinyConfigError::FileOpenFailed;
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (slotGeneration != 0) {
+            File f = openFile(SlotFileStrings[activeSlot].c_str(), "r");
+            if (f) {
+                bool loaded = parseFile(f, doc, format, filter);
+                closeFile(f);
+                if (loaded) {
+                    return true;
+                }
+                failure = lastError;
+                if (failure != TinyConfigError::ChecksumMismatch) {
+                    break;
+                }
+            }
+        }
+        FileHeader other;
+        uint8_t otherSlot = activeSlot ^ 1;
+        if (attempt > 0 || !readSlotHeader(otherSlot, other)) {
+            break;
+        }
+        activeSlot = otherSlot;
+        slotGeneration = other.generation;
+    }
+    lastError = failure;
+    return false;
+}
+
+/**
+ * @brief Writes the next copy of the configuration in atomic save mode.
+ * @param doc The document to write.
+ * @return true if writing succeeded, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * The older copy is overwritten, so the active copy stays intact until the new one is complete.
+ */
+bool TinyConfig::writeSlot(const JsonDocument& doc) {
+    uint8_t target = activeSlot ^ 1;
+    if (!writeDoc(doc, SlotFileStrings[target].c_str(), true, slotGeneration + 1)) {
+        return false;
+    }
+    activeSlot = target;
+    slotGeneration++;
+    return true;
+}
+
+/**
+ * @brief Opens a file and records the time spent in the stats.
+ * @param path The file to open.
+ * @param mode The LittleFS open mode.
+ * @return The opened file; check it with operator bool.
+ */
+File TinyConfig::openFile(const char* path, const char* mode) {
+    uint32_t start = micros();
+    File file = LittleFS.open(path, mode);
+    addTiming(stats.fsMicros, stats.fsMaxMicros, start);
+    return file;
+}
+
+/**
+ * @brief Closes a file and records the time spent in the stats.
+ * @param file The file to close.
+ */
+void TinyConfig::closeFile(File& file) {
+    uint32_t start = micros();
+    file.close();
+    addTiming(stats.fsMicros, stats.fsMaxMicros, start);
+}
+
+/**
+ * @brief Loads the configuration file into a document.
+ * @param doc Reference to the document to load into.
+ * @param filter If not nullptr, only the members marked true in this document are kept.
+ * @return true if loading succeeded, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * This function opens the configuration file in read mode and attempts to deserialize its contents into the provided document.
+ * If the file cannot be opened or read, or if the JSON parsing fails, it sets the lastError accordingly.
+ * If the filesystem is not initialized, it sets the lastError to FSNotRunning.
+ * If the file is successfully loaded, it sets lastError to None.
+ */
+bool TinyConfig::loadDoc(JsonDocument& doc, const JsonDocument* filter) {
+    if (atomicSave) {
+        return loadSlot(doc, filter);
+    }
+    File f = openFile(configPath(format), "r");
+    if (!f) {
+        lastError = TinyConfigError::FileOpenFailed;
+        return false;
+    }
+    bool loaded = parseFile(f, doc, format, filter);
+    closeFile(f);
+    return loaded;
+}
+
+/**
+ * @brief Saves a document to the configuration file.
+ * @param doc The document to save.
+ * @return true if saving succeeded, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * In log mode this writes a new snapshot: the document goes to a temporary file, the log is removed and the temporary
+ * file is renamed over the configuration file. If power is lost in between, recoverSnapshot() finishes or discards
+ * the snapshot on the next load, so the configuration is either the old snapshot plus its log or the new snapshot.
+ * In atomic save mode the document is written as the next copy instead; in log mode the log is removed afterwards.
+ */
+bool TinyConfig::saveDoc(const JsonDocument& doc) {
+    if (atomicSave) {
+        if (!writeSlot(doc)) {
+            return false;
+        }
+        if (logMode) {
+            // Replaying the old log on top of the new copy would only repeat changes it already contains
+            logBytes = 0;
+            stats.compactions++;
+            if (LittleFS.exists(LogFileString.c_str()) && !LittleFS.remove(LogFileString.c_str())) {
+                lastError = TinyConfigError::FileWriteFailed;
+                return false;
+            }
+        }
+        return true;
+    }
+    if (!logMode) {
+        return writeDoc(doc, configPath(format), fileHeader);
+    }
+    if (!writeDoc(doc, SnapshotTempString.c_str(), fileHeader)) {
+        LittleFS.remove(SnapshotTempString.c_str());
+        return false;
+    }
+    if (LittleFS.exists(LogFileString.c_str()) && !LittleFS.remove(LogFileString.c_str())) {
+        LittleFS.remove(SnapshotTempString.c_str());
+        lastError = TinyConfigError::FileWriteFailed;
+        return false;
+    }
+    logBytes = 0;
+    if (!LittleFS.rename(SnapshotTempString.c_str(), configPath(format))) {
+        lastError = TinyConfigError::FileWriteFailed;
+        return false;
+    }
+    stats.compactions++;
+    lastError = TinyConfigError::None;
+    return true;
+}
+
+/**
+ * @brief Writes a document to a file.
+ * @param doc The document to write.
+ * @param path The file to write.
+ * @param header true to write a header with the length and CRC of the document in front of it.
+ * @param headerGeneration The generation recorded in the header (copies of atomic save mode), otherwise 0.
+ * @return true if writing succeeded, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * This function opens the file in write mode and serializes the provided document to it.
+ * The document is streamed to the file through a small buffer; no serialized copy is kept in RAM.
+ * The header is written as zeros first and filled in once the document is complete, so an interrupted write
+ * never leaves a valid header behind.
+ * If the file cannot be opened or written to, it sets the lastError accordingly.
+ */
+bool TinyConfig::writeDoc(const JsonDocument& doc, const char* path, bool header, uint32_t headerGeneration) {
+    File f = openFile(path, "w");
+    if (!f) {
+        lastError = TinyConfigError::FileOpenFailed;
+        return false;
+    }
+    stats.saveCount++;
+    uint8_t raw[FileHeaderSize] = {};
+    if (header && f.write(raw, sizeof(raw)) != sizeof(raw)) {
+        lastError = TinyConfigError::FileWriteFailed;
+        closeFile(f);
+        return false;
+    }
+    uint32_t start = micros();
+    ChecksumWriter checked(f);
+    BufferedWriter out(checked);
+    size_t written = serializeDoc(doc, out);
+    bool flushed = out.finish();
+    addTiming(stats.serializeMicros, stats.serializeMaxMicros, start);
+    stats.bytesSerialized += written;
+    if (written == 0 || !flushed) {
+        lastError = TinyConfigError::FileWriteFailed;
+        closeFile(f);
+        return false;
+    }
+    if (header) {
+        raw[0] = FileMagic[0];
+        raw[1] = FileMagic[1];
+        raw[2] = FileHeaderVersion;
+        raw[3] = static_cast<uint8_t>(format);
+        putU32(raw + 4, headerGeneration);
+        putU32(raw + 8, written);
+        putU32(raw + 12, checked.checksum);
+        if (!f.seek(0) || f.write(raw, sizeof(raw)) != sizeof(raw)) {
+            lastError = TinyConfigError::FileWriteFailed;
+            closeFile(f);
+            return false;
+        }
+    }
+    closeFile(f);
+    stats.flashWrites++;
+    fileBytes = written;
+    if (&doc == cachedDoc()) {
+        cacheBytes = written;
+    }
+    lastError = TinyConfigError::None;
+    return true;
+}
+
+/**
+ * @brief Finishes or discards a snapshot that was interrupted by a reset or power loss.
+ * @return true if there was nothing to recover or recovery succeeded, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * A leftover temporary snapshot is discarded while the log still exists, because the old snapshot and the log
+ * are complete. Without a log, the snapshot was written completely before the log was removed, unless it does not
+ * parse; a complete snapshot is renamed over the configuration file.
+ */
+bool TinyConfig::recoverSnapshot() {
+    if (!LittleFS.exists(SnapshotTempString.c_str())) {
+        return true;
+    }
+    if (atomicSave) {
+        // Snapshots are written as copies in atomic save mode; this one is left over from before
+        LittleFS.remove(SnapshotTempString.c_str());
+        return true;
+    }
+    bool complete = false;
+    if (!LittleFS.exists(LogFileString.c_str())) {
+        DynamicJsonDocument snapshot(maxFileSize);
+        File f = openFile(SnapshotTempString.c_str(), "r");
+        complete = f && parseFile(f, snapshot, format);
+        closeFile(f);
+    }
+    if (!complete) {
+        LittleFS.remove(SnapshotTempString.c_str());
+        return true;
+    }
+    if (!LittleFS.rename(SnapshotTempString.c_str(), configPath(format))) {
+        lastError = TinyConfigError::FileWriteFailed;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Applies the records of the log to a document loaded from the snapshot.
+ * @param doc The document to update.
+ * @return true if the log was replayed, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * Every line of the log is a JSON object with the keys that were set, and null for keys that were deleted.
+ * Replay stops at the first record that does not parse, which is the partial record of an interrupted append.
+ * In that case a snapshot is written right away, so that new records are not appended after the broken one.
+ */
+bool TinyConfig::replayLog(JsonDocument& doc) {
+    logBytes = 0;
+    if (!LittleFS.exists(LogFileString.c_str())) {
+        return true;
+    }
+    File f = openFile(LogFileString.c_str(), "r");
+    if (!f) {
+        lastError = TinyConfigError::FileOpenFailed;
+        return false;
+    }
+    stats.loadCount++;
+    DynamicJsonDocument record(maxFileSize);
+    bool torn = false;
+    bool full = false;
+    uint32_t start = micros();
+    while (!torn && !full) {
+        DeserializationError err = deserializeJson(record, f);
+        if (err == DeserializationError::EmptyInput) {
+            break;
+        }
+        if (err) {
+            torn = true;
+            break;
+        }
+        for (JsonPairConst member : record.as<JsonObjectConst>()) {
+            String key = member.key().c_str();
+            if (member.value().isNull()) {
+                doc.remove(key);
+            } else if (!doc[key].set(member.value())) {
+                compactDoc(doc);
+                if (!doc[key].set(member.value())) {
+                    full = true;
+                    break;
+                }
+            }
+        }
+        logBytes = f.position();
+    }
+    addTiming(stats.parseMicros, stats.parseMaxMicros, start);
+    stats.bytesParsed += f.position();
+    closeFile(f);
+    if (full) {
+        lastError = TinyConfigError::FileSizeTooLarge;
+        return false;
+    }
+    if (torn && !saveDoc(doc)) {
+        return false;
+    }
+    lastError = TinyConfigError::None;
+    return true;
+}
+
+/**
+ * @brief Appends one record to the log.
+ * @param patch The change as a JSON object, with null values for deleted keys.
+ * @return true if the record was written completely, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ */
+bool TinyConfig::appendLog(const JsonDocument& patch) {
+    File f = openFile(LogFileString.c_str(), "a");
+    if (!f) {
+        lastError = TinyConfigError::FileOpenFailed;
+        return false;
+    }
+    uint32_t start = micros();
+    BufferedWriter out(f);
+    size_t written = serializeJson(patch, out);
+    written += out.write(static_cast<uint8_t>('\n'));
+    bool flushed = out.finish();
+    addTiming(stats.serializeMicros, stats.serializeMaxMicros, start);
+    stats.bytesSerialized += written;
+    closeFile(f);
+    if (written < 2 || !flushed) {
+        lastError = TinyConfigError::FileWriteFailed;
+        return false;
+    }
+    stats.flashWrites++;
+    stats.logAppends++;
+    logBytes += written;
+    lastError = TinyConfigError::None;
+    return true;
+}
+
+/**
+ * @brief Provides the document that an operation should read from or modify.
+ * @param scratch Owner for a freshly loaded document when cache mode is off.
+ * @return Pointer to the document, or nullptr if it could not be loaded. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * In cache mode, write-back mode and log mode this returns the cached document, loading it first if it is not valid yet.
+ * For TinyConfigStatic the cached document is the one inside the object.
+ * In log mode loading means reading the last snapshot and replaying the log on top of it.
+ * Otherwise the configuration file is loaded into a new document owned by scratch, or into the parse buffer kept
+ * between calls if setReuseParseBuffer() is enabled.
+ */
+JsonDocument* TinyConfig::openDoc(std::unique_ptr<DynamicJsonDocument>& scratch) {
+    if (isResident()) {
+        if (!cachedDoc()) {
+            cacheDoc.reset(new DynamicJsonDocument(maxFileSize));
+            cacheValid = false;
+        }
+        JsonDocument* cached = cachedDoc();
+        if (!cacheValid) {
+            cacheBytes = 0;
+            if (logMode && !recoverSnapshot()) {
+                return nullptr;
+            }
+            if (!loadDoc(*cached)) {
+                return nullptr;
+            }
+            if (logMode && !replayLog(*cached)) {
+                return nullptr;
+            }
+            cacheValid = true;
+            ++generation;
+        }
+        return cached;
+    }
+    if (reuseParseBuffer) {
+        if (!parseDoc) {
+            parseDoc.reset(new DynamicJsonDocument(maxFileSize));
+        }
+        if (!loadDoc(*parseDoc)) {
+            return nullptr;
+        }
+        return parseDoc.get();
+    }
+    scratch.reset(new DynamicJsonDocument(maxFileSize));
+    if (!loadDoc(*scratch)) {
+        return nullptr;
+    }
+    return scratch.get();
+}
+
+/**
+ * @brief Saves a modified document to the configuration file.
+ * @param doc The modified document, as returned by openDoc().
+ * @param bytes The serialized size of the document if the caller knows it, 0 otherwise.
+ * @param patch The change as a JSON object, with null values for deleted keys, or nullptr to always write the whole document.
+ * @return true if the document was saved, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * In write-back mode the document is only marked dirty and written later by commit() or tick().
+ * In log mode the patch is appended to the log, and a snapshot is written once the log grows past the compact threshold.
+ * If appending fails, a snapshot is written instead, since the log may end in a partial record.
+ * If saving fails, the cached document no longer matches the file, so it is marked invalid and reloaded on the next access.
+ */
+bool TinyConfig::storeDoc(JsonDocument& doc, size_t bytes, const JsonDocument* patch) {
+    if (&doc == cachedDoc()) {
+        cacheBytes = bytes;
+    }
+    if (writeBack) {
+        dirty = true;
+        lastChangeMillis = millis();
+        lastError = TinyConfigError::None;
+        return true;
+    }
+    if (logMode && patch && appendLog(*patch)) {
+        if (logBytes > compactThreshold) {
+            saveDoc(doc); // on failure the log is kept and compaction is retried after the next append
+        }
+        lastError = TinyConfigError::None;
+        return true;
+    }
+    if (!saveDoc(doc)) {
+        cacheValid = false;
+        return false;
+    }
+    lastError = TinyConfigError::None;
+    return true;
+}
+
+/**
+ * @brief Checks whether setting a key keeps the configuration within its limits.
+ * @tparam T The type of the value to set.
+ * @param doc The document that is about to be modified.
+ * @param key The key to set.
+ * @param value The value to set.
+ * @param fileSize Receives the serialized size of the document after the change.
+ * @return true if the value fits, false otherwise. On failure, lastError is set to FileSizeTooLarge.
+ * 
+ * The resulting file size is computed without applying the change, so a rejected value leaves the document untouched.
+ * For the cached document the size is tracked between calls, so only the changed member has to be measured.
+ * This matters in write-back mode, where the document holds changes that are not in the file yet.
+ * If the document's memory pool is too full for the value, it is compacted once before giving up.
+ */
+template <typename K, typename T>
+bool TinyConfig::fitsAfterSet(JsonDocument& doc, const K& key, const T& value, size_t& fileSize) {
+    StaticJsonDocument<JSON_OBJECT_SIZE(1)> probe;
+    probe[keyChars(key)] = probeValue(value);
+    JsonObjectConst root = doc.as<JsonObjectConst>();
+    fileSize = (&doc == cachedDoc() && cacheBytes > 0) ? cacheBytes : measureDoc(doc.as<JsonVariantConst>());
+    size_t poolSize = copiedSize(value);
+    if (root.containsKey(jsonKey(key))) {
+        fileSize = fileSize - measureValue(root[jsonKey(key)]) + measureValue(probe.as<JsonObjectConst>()[keyChars(key)]);
+    } else if (format != TinyConfigFormat::Json) {
+        // A map with 16 or more members needs a 3 byte header instead of 1; the probe's index preamble is not added
+        size_t overhead = 1 + (format == TinyConfigFormat::Indexed ? IndexPreambleSize : 0);
+        fileSize += measureDoc(probe.as<JsonVariantConst>()) - overhead + (root.size() == 15 ? 2 : 0);
+        poolSize += JSON_OBJECT_SIZE(1) + keyLength(key) + 1;
+    } else {
+        fileSize += measureDoc(probe.as<JsonVariantConst>()) - 2 + (root.size() > 0 ? 1 : 0);
+        poolSize += JSON_OBJECT_SIZE(1) + keyLength(key) + 1;
+    }
+    if (fileSize > maxFileSize) {
+        lastError = TinyConfigError::FileSizeTooLarge;
+        return false;
+    }
+    if (doc.memoryUsage() + poolSize > doc.capacity()) {
+        if (!compactDoc(doc)) {
+            return false;
+        }
+        if (doc.memoryUsage() + poolSize > doc.capacity()) {
+            lastError = TinyConfigError::FileSizeTooLarge;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Replaces the whole configuration with a document built outside of openDoc().
+ * @param doc The new configuration. Its contents are moved into the cache when one is kept.
+ * @return true if the configuration was replaced, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * The document is written with a single saveDoc() call, or just marked dirty in write-back mode.
+ * If the serialized document exceeds maxFileSize, or does not fit the document of TinyConfigStatic, it sets lastError
+ * to FileSizeTooLarge and nothing is changed, neither the file nor the cached document with its uncommitted changes.
+ * Whether the document fits TinyConfigStatic is tried on a copy first, since set() clears the target before copying.
+ */
+bool TinyConfig::replaceDoc(DynamicJsonDocument& doc) {
+    size_t bytes = measureDoc(doc.as<JsonVariantConst>());
+    if (bytes > maxFileSize || (staticDoc && doc.memoryUsage() > staticDoc->capacity())) {
+        lastError = TinyConfigError::FileSizeTooLarge;
+        return false;
+    }
+    if (staticDoc) {
+        DynamicJsonDocument trial(staticDoc->capacity());
+        if (!trial.set(doc)) {
+            lastError = TinyConfigError::FileSizeTooLarge;
+            return false;
+        }
+    }
+    if (!writeBack && !saveDoc(doc)) {
+        return false;
+    }
+    if (staticDoc) {
+        if (!staticDoc->set(doc)) {
+            cacheValid = false; // the file still holds the configuration, if it was saved
+            lastError = TinyConfigError::FileSizeTooLarge;
+            return false;
+        }
+        cacheValid = true;
+        cacheBytes = bytes;
+        dirty = writeBack;
+        lastChangeMillis = millis();
+    } else if (isResident()) {
+        cacheDoc.reset(new DynamicJsonDocument(std::move(doc)));
+        cacheValid = true;
+        cacheBytes = bytes;
+        dirty = writeBack;
+        lastChangeMillis = millis();
+    }
+    ++generation;
+    lastError = TinyConfigError::None;
+    return true;
+}
+
+/**
+ * @brief Calls the onChange() handlers of the keys that changed.
+ * @param changes The changed keys with their new values, null for deleted keys.
+ * @param wholeConfig true if changes is the whole configuration, so subscribed keys missing from it get a null value.
+ * @param changed If not nullptr, one flag per subscription as returned by changedKeys(); only flagged ones are called.
+ * 
+ * Handlers may change the configuration and subscribe further handlers; new handlers are called from the next
+ * change on. Without subscriptions this costs nothing.
+ */
+void TinyConfig::notifyChanges(JsonObjectConst changes, bool wholeConfig, const std::vector<bool>* changed) {
+    size_t count = changeSubscriptions.size();
+    for (size_t i = 0; i < count && i < changeSubscriptions.size(); ++i) {
+        if (changed && (i >= changed->size() || !(*changed)[i])) {
+            continue;
+        }
+        if (!wholeConfig && !changes.containsKey(changeSubscriptions[i].key)) {
+            continue;
+        }
+        ChangeSubscription subscription = changeSubscriptions[i]; // a handler may change changeSubscriptions
+        subscription.handler(subscription.key.c_str(), changes[subscription.key]);
+    }
+}
+
+/**
+ * @brief Finds the onChange() subscriptions whose key gets another value from a new configuration.
+ * @param next The configuration that is about to replace the current one.
+ * @return One flag per subscription, true if its key changes; empty without subscriptions.
+ * 
+ * Outside of cache mode this loads the current configuration, so it only costs a parse when someone is subscribed.
+ * If the current configuration cannot be loaded, every key counts as changed.
+ */
+std::vector<bool> TinyConfig::changedKeys(JsonDocument& next) {
+    std::vector<bool> changed;
+    if (changeSubscriptions.empty()) {
+        return changed;
+    }
+    std::unique_ptr<DynamicJsonDocument> scratch;
+    JsonDocument* current = openDoc(scratch);
+    JsonObjectConst after = next.as<JsonObjectConst>();
+    for (const ChangeSubscription& subscription : changeSubscriptions) {
+        changed.push_back(!current || !(current->as<JsonObjectConst>()[subscription.key] == after[subscription.key]));
+    }
+    return changed;
+}
+
+/**
+ * @brief Looks up a member of a document.
+ * @param doc The document to search.
+ * @param key The key to look up.
+ * @return The value, or null if the key does not exist.
+ */
+JsonVariantConst TinyConfig::findMember(JsonDocument& doc, const String& key) {
+    return doc.as<JsonObjectConst>()[key];
+}
+
+/**
+ * @brief Looks up a member of a document, remembering recent lookups in the cached document.
+ * @param doc The document to search.
+ * @param key The key to look up.
+ * @return The value, or null if the key does not exist.
+ * 
+ * ArduinoJson compares the key with every member name in turn. For the cached document, the result is kept in a small
+ * table indexed by the key's hash, so repeated lookups of the same key only compare a hash and a name. The table is
+ * invalidated by the generation counter whenever the document may have changed.
+ */
+JsonVariantConst TinyConfig::findMember(JsonDocument& doc, TinyConfigKey key) {
+    if (&doc != cachedDoc()) {
+        return doc.as<JsonObjectConst>()[key.name];
+    }
+    if (!keySlots) {
+        keySlots.reset(new KeySlot[KeySlotCount]);
+    }
+    KeySlot& slot = keySlots[key.hash % KeySlotCount];
+    if (slot.generation == generation && slot.hash == key.hash &&
+        (slot.name == key.name || strcmp(slot.name, key.name) == 0)) {
+        return slot.value;
+    }
+    slot.name = key.name;
+    slot.hash = key.hash;
+    slot.generation = generation;
+    slot.value = doc.as<JsonObjectConst>()[key.name];
+    return slot.value;
+}
+
 /**
  * @brief Internal helper to set a value in the configuration.
+ * @tparam K The key type, String or TinyConfigKey.
  * @tparam T The type of the value to set.
  * @param key The key to set.
  * @param value The value to set.
  * @return true if the value was set successfully, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
  * 
- * This function loads the configuration file into a DynamicJsonDocument, sets the specified key to the provided value,
- * and saves the document back to the file. It checks if the file size exceeds the maximum allowed size.
+ * This function loads the configuration file into a DynamicJsonDocument (or uses the cached one), sets the specified key
+ * to the provided value, and saves the document back to the file (or marks it dirty in write-back mode).
+ * It checks if the file size would exceed the maximum allowed size before changing anything.
+ * In an indexed file that is not kept in RAM, an existing int or float is overwritten in place when possible.
  * If the filesystem is not initialized, it sets the lastError to FSNotRunning.
- * If the file size exceeds maxFileSize, it sets the lastError to FileTooLarge.
+ * If the value does not fit into the document or the file size exceeds maxFileSize, it sets the lastError to FileSizeTooLarge.
  * If the file is successfully updated, it sets lastError to None.
  */
-template <typename T>
-bool TinyConfig::setInternal(const String& key, T value) {
+template <typename K, typename T>
+bool TinyConfig::setInternal(const K& key, T value) {
     if (!isInitialized) {
         lastError = TinyConfigError::FSNotRunning;
         return false;
     }
-    DynamicJsonDocument doc(maxFileSize);
-    if (!loadDoc(doc)) {
+    StaticJsonDocument<JSON_OBJECT_SIZE(1)> patch;
+    patch[keyChars(key)] = probeValue(value);
+    uint8_t type;
+    uint32_t bits;
+    bool changed = true;
+    if (format == TinyConfigFormat::Indexed && !isResident() && !atomicSave && packFixed(value, type, bits) &&
+        patchMember(keyChars(key), keyHash(key), type, bits, changed)) {
+        ++generation;
+        lastError = TinyConfigError::None;
+        if (changed) {
+            notifyChanges(patch.as<JsonObjectConst>(), false);
+        }
+        return true;
+    }
+    std::unique_ptr<DynamicJsonDocument> scratch;
+    JsonDocument* doc = openDoc(scratch);
+    if (!doc) {
         return false;
     }
-    doc[key] = value;
-    String jsonString;
-    serializeJson(doc, jsonString);
-    if (jsonString.length() > maxFileSize) {
+    size_t fileSize = 0;
+    if (!fitsAfterSet(*doc, key, value, fileSize)) {
+        return false;
+    }
+    bool added = !doc->as<JsonObjectConst>().containsKey(jsonKey(key));
+    changed = added || !(doc->as<JsonObjectConst>()[jsonKey(key)] == patch.as<JsonObjectConst>()[keyChars(key)]);
+    if (!(*doc)[jsonKey(key)].set(value)) {
         lastError = TinyConfigError::FileSizeTooLarge;
+        if (added) {
+            doc->remove(jsonKey(key)); // the member is created before its value is copied
+            return false;
+        }
+        ++generation;
+        if (!dirty) {
+            cacheValid = false;
+        }
+        cacheBytes = 0;
         return false;
     }
-    if (!saveDoc(doc)) {
+    ++generation;
+    if (!storeDoc(*doc, fileSize, &patch)) {
+        return false;
+    }
+    if (changed) {
+        notifyChanges(patch.as<JsonObjectConst>(), false);
+    }
+    return true;
+}
+
+/**
+ * @brief Internal helper to get a value from the configuration.
+ * @tparam K The key type, String or TinyConfigKey.
+ * @tparam T The type of the value to get.
+ * @param key The key to retrieve.
+ * @param fallback The fallback value if the key does not exist or on error.
+ * @return The stored value or fallback. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * In cache mode the value is read from the cached document, otherwise the configuration file is loaded.
+ * A key that is not stored gets its entry of the defaults table, if there is one of a matching type.
+ * If the filesystem is not initialized, it sets the lastError to FSNotRunning.
+ */
+template <typename K, typename T>
+T TinyConfig::getInternal(const K& key, T fallback) {
+    if (!isInitialized) {
+        lastError = TinyConfigError::FSNotRunning;
+        return fallback;
+    }
+    if (!isResident()) {
+        StaticJsonDocument<MemberDocSize> small;
+        std::unique_ptr<DynamicJsonDocument> large;
+        JsonDocument& member = memberDoc(small, large, std::is_same<T, String>::value);
+        if (loadMember(key, member)) {
+            JsonVariantConst value = member.as<JsonObjectConst>()[keyChars(key)];
+            return value.isNull() ? defaultOr(keyChars(key), fallback) : value | fallback;
+        }
+    }
+    std::unique_ptr<DynamicJsonDocument> scratch;
+    JsonDocument* doc = openDoc(scratch);
+    if (!doc) {
+        return fallback;
+    }
+    lastError = TinyConfigError::None;
+    JsonVariantConst value = findMember(*doc, key);
+    return value.isNull() ? defaultOr(keyChars(key), fallback) : value | fallback;
+}
+
+/**
+ * @brief Sets or updates an integer value in the configuration.
+ * @param key The key to set.
+ * @param value The integer value to set.
+ * @return true if the value was set successfully, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ */
+bool TinyConfig::set(const String& key, int value) {
+    return setInternal(key, value);
+}
+
+/**
+ * @brief Sets or updates a float value in the configuration.
+ * @param key The key to set.
+ * @param value The float value to set.
+ * @return true if the value was set successfully, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ */
+bool TinyConfig::set(const String& key, float value) {
+    return setInternal(key, value);
+}
+
+/**
+ * @brief Sets or updates a string value in the configuration.
+ * @param key The key to set.
+ * @param value The string value to set.
+ * @return true if the value was set successfully, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ */
+bool TinyConfig::set(const String& key, const String& value) {
+    return setInternal(key, value);
+}
+
+/**
+ * @brief Gets an integer value from the configuration.
+ * @param key The key to retrieve.
+ * @param fallback The fallback value if the key does not exist or on error.
+ * @return The integer value or fallback. If the key does not exist or an error occurs, the fallback value is returned.
+ * 
+ * Check getLastError() or getLastErrorString() for details on any errors that occur.
+ */
+int TinyConfig::getInt(const String& key, int fallback) {
+    return getInternal(key, fallback);
+}
+
+/**
+ * @brief Gets a float value from the configuration.
+ * @param key The key to retrieve.
+ * @param fallback The fallback value if the key does not exist or on error.
+ * @return The float value or fallback. If the key does not exist or an error occurs, the fallback value is returned.
+ * 
+ * Check getLastError() or getLastErrorString() for details on any errors that occur.
+ */
+float TinyConfig::getFloat(const String& key, float fallback) {
+    return getInternal(key, fallback);
+}
+
+/**
+ * @brief Gets a string value from the configuration. 
+ * @param key The key to retrieve.
+ * @param fallback The fallback value if the key does not exist or on error.
+ * @return The string value or fallback. If the key does not exist or an error occurs, the fallback value is returned.
+ * 
+ * Check getLastError() or getLastErrorString() for details on any errors that occur.
+ */
+String TinyConfig::getString(const String& key, const String& fallback) {
+    return getInternal<String, String>(key, fallback);
+}
+
+/**
+ * @brief Sets or updates an integer value in the configuration.
+ * @param key The key to set, created with TC_KEY().
+ * @param value The integer value to set.
+ * @return true if the value was set successfully, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * Unlike the String overload, no String is created for the key, and a new key's name is not copied into the document.
+ */
+bool TinyConfig::set(TinyConfigKey key, int value) {
+    return setInternal(key, value);
+}
+
+/**
+ * @brief Sets or updates a float value in the configuration.
+ * @param key The key to set, created with TC_KEY().
+ * @param value The float value to set.
+ * @return true if the value was set successfully, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ */
+bool TinyConfig::set(TinyConfigKey key, float value) {
+    return setInternal(key, value);
+}
+
+/**
+ * @brief Sets or updates a string value in the configuration.
+ * @param key The key to set, created with TC_KEY().
+ * @param value The string value to set.
+ * @return true if the value was set successfully, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ */
+bool TinyConfig::set(TinyConfigKey key, const String& value) {
+    return setInternal(key, value);
+}
+
+/**
+ * @brief Gets an integer value from the configuration.
+ * @param key The key to retrieve, created with TC_KEY().
+ * @param fallback The fallback value if the key does not exist or on error.
+ * @return The integer value or fallback.
+ * 
+ * In cache, write-back and log mode, repeated lookups of the same key are answered from a small hash table.
+ */
+int TinyConfig::getInt(TinyConfigKey key, int fallback) {
+    return getInternal(key, fallback);
+}
+
+/**
+ * @brief Gets a float value from the configuration.
+ * @param key The key to retrieve, created with TC_KEY().
+ * @param fallback The fallback value if the key does not exist or on error.
+ * @return The float value or fallback.
+ */
+float TinyConfig::getFloat(TinyConfigKey key, float fallback) {
+    return getInternal(key, fallback);
+}
+
+/**
+ * @brief Gets a string value from the configuration.
+ * @param key The key to retrieve, created with TC_KEY().
+ * @param fallback The fallback value if the key does not exist or on error.
+ * @return The string value or fallback.
+ */
+String TinyConfig::getString(TinyConfigKey key, const String& fallback) {
+    return getInternal<TinyConfigKey, String>(key, fallback);
+}
+
+/**
+ * @brief Copies a string value from the configuration into a buffer.
+ * @param key The key to retrieve.
+ * @param buffer The buffer to copy the value into. It is always null-terminated.
+ * @param length The size of the buffer in bytes.
+ * @param fallback The text to copy if the key does not exist, is not a string, or on error.
+ * @return true if the value or fallback was copied completely, false otherwise. If the text did not fit, it is cut and lastError is BufferTooSmall; check getLastError() or getLastErrorString() for details.
+ * 
+ * Unlike the String overload, no String is created for the value. In cache, write-back or log mode, combined with a
+ * TC_KEY() key, reading a value does not allocate any heap.
+ */
+bool TinyConfig::getString(const String& key, char* buffer, size_t length, const char* fallback) {
+    return copyString(key, buffer, length, fallback);
+}
+
+/**
+ * @brief Copies a string value from the configuration into a buffer.
+ * @param key The key to retrieve, created with TC_KEY().
+ * @param buffer The buffer to copy the value into. It is always null-terminated.
+ * @param length The size of the buffer in bytes.
+ * @param fallback The text to copy if the key does not exist, is not a string, or on error.
+ * @return true if the value or fallback was copied completely, false otherwise. If the text did not fit, it is cut and lastError is BufferTooSmall; check getLastError() or getLastErrorString() for details.
+ */
+bool TinyConfig::getString(TinyConfigKey key, char* buffer, size_t length, const char* fallback) {
+    return copyString(key, buffer, length, fallback);
+}
+
+/**
+ * @brief Parses only one member of the configuration file into a small document.
+ * @tparam K The key type, String or TinyConfigKey.
+ * @param key The key to look up.
+ * @param member The document to parse into; on success it holds the member, if it exists.
+ * @return true if the file was parsed, false otherwise.
+ * 
+ * When the configuration is not kept in RAM, getters use this before loading the whole file: ArduinoJson skips all
+ * other members while parsing, so the parse only allocates what the getter returns. An indexed file is searched with
+ * seekMember() instead. If the member does not fit into member, or on any other failure, the getter loads the whole
+ * file as before.
+ */
+template <typename K>
+bool TinyConfig::loadMember(const K& key, JsonDocument& member) {
+    if (format == TinyConfigFormat::Indexed && !atomicSave && seekMember(keyChars(key), keyHash(key), member)) {
+        return true;
+    }
+    StaticJsonDocument<JSON_OBJECT_SIZE(1)> filter;
+    filter[keyChars(key)] = true;
+    return loadDoc(member, &filter);
+}
+
+/**
+ * @brief Picks the document a single member is parsed into.
+ * @param small The document on the stack.
+ * @param large Owner for a larger document, if one is needed.
+ * @param text true if the member is read as a string.
+ * @return small, or the document allocated in large.
+ * 
+ * A number always fits into small. A string can be nearly as long as the file, so for strings a document that holds
+ * the whole document length is allocated, taken from the last load or save, or maxFileSize if it is not known yet.
+ * This still allocates less than a full parse, and a long value needs no second, full parse.
+ */
+JsonDocument& TinyConfig::memberDoc(JsonDocument& small, std::unique_ptr<DynamicJsonDocument>& large, bool text) {
+    size_t capacity = JSON_OBJECT_SIZE(1) + (fileBytes != 0 && fileBytes < maxFileSize ? fileBytes : maxFileSize);
+    if (!text || capacity <= small.capacity()) {
+        return small;
+    }
+    large.reset(new DynamicJsonDocument(capacity));
+    return *large;
+}
+
+/**
+ * @brief Looks up one member of an indexed file without parsing the file.
+ * @param key The key to look up.
+ * @param hash The hash of key, as computed by tinyConfigHash().
+ * @param member The document to store the member in; on success it holds the member, if it exists.
+ * @return true if the member was looked up and lastError is None, false if the file cannot be searched this way.
+ * 
+ * A binary search over the index reads about log2(number of keys) entries of 8 bytes, then the key and the value are
+ * read. Only ints, floats and strings that fit into member are read this way. Files with a header are left to the
+ * parser, which checks their CRC.
+ */
+bool TinyConfig::seekMember(const char* key, uint32_t hash, JsonDocument& member) {
+    File f = openFile(configPath(format), "r");
+    if (!f) {
+        return false;
+    }
+    uint32_t start = micros();
+    IndexReader reader(f);
+    bool found = false;
+    bool answered = reader.find(key, hash, found);
+    uint8_t type = 0;
+    uint32_t bits = 0;
+    size_t length = 0;
+    char text[MemberDocSize];
+    if (answered && found) {
+        answered = reader.readType(type);
+        if (answered && (type == PackedInt || type == PackedFloat)) {
+            answered = reader.readBE32(bits);
+        } else if (answered && reader.readStringLength(type, length) && length < sizeof(text) - JSON_OBJECT_SIZE(1)) {
+            answered = reader.read(reinterpret_cast<uint8_t*>(text), length);
+            text[length] = '\0';
+        } else {
+            answered = false;
+        }
+    }
+    addTiming(stats.parseMicros, stats.parseMaxMicros, start);
+    stats.bytesParsed += reader.bytesRead;
+    closeFile(f);
+    if (!answered) {
+        return false;
+    }
+    stats.loadCount++;
+    lastError = TinyConfigError::None;
+    member.to<JsonObject>();
+    if (!found) {
+        return true;
+    }
+    if (type == PackedInt) {
+        member[key] = static_cast<int32_t>(bits);
+    } else if (type == PackedFloat) {
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        member[key] = value;
+    } else {
+        member[key] = static_cast<char*>(text); // char* is copied into member
+    }
+    return true;
+}
+
+/**
+ * @brief Overwrites an int or float value of an indexed file in place.
+ * @param key The key to set.
+ * @param hash The hash of key, as computed by tinyConfigHash().
+ * @param type The MessagePack type of the new value, int32 or float32.
+ * @param bits The new value.
+ * @param changed Set to true if the stored value differed from bits.
+ * @return true if the value was overwritten, false if the file has to be rewritten instead.
+ * 
+ * This works if key exists and holds a value of the same type: only its 4 bytes are written, so the file keeps its
+ * size and the index stays valid. LittleFS commits the change when the file is closed, so after a power loss the
+ * file holds either the old or the new value.
+ */
+bool TinyConfig::patchMember(const char* key, uint32_t hash, uint8_t type, uint32_t bits, bool& changed) {
+    File f = openFile(configPath(format), "r+");
+    if (!f) {
+        return false;
+    }
+    IndexReader reader(f);
+    bool found = false;
+    uint8_t stored = 0;
+    uint32_t previous = 0;
+    bool patched = reader.find(key, hash, found) && found && reader.readType(stored) && stored == type &&
+                   reader.readBE32(previous);
+    stats.bytesParsed += reader.bytesRead;
+    if (patched) {
+        changed = previous != bits;
+        uint8_t raw[4];
+        putBE32(raw, bits);
+        patched = f.seek(f.position() - sizeof(raw)) && f.write(raw, sizeof(raw)) == sizeof(raw); // back over the old value
+        if (patched) {
+            stats.saveCount++;
+            stats.flashWrites++;
+            stats.bytesSerialized += sizeof(raw);
+        }
+    }
+    closeFile(f);
+    return patched;
+}
+
+/**
+ * @brief Internal helper to copy a string value into a buffer.
+ * @tparam K The key type, String or TinyConfigKey.
+ * @param key The key to retrieve.
+ * @param buffer The buffer to copy the value into.
+ * @param length The size of the buffer in bytes.
+ * @param fallback The text to copy if the key does not exist, is not a string, or on error.
+ * @return true if the value or fallback was copied completely and no error occurred, false otherwise.
+ */
+template <typename K>
+bool TinyConfig::copyString(const K& key, char* buffer, size_t length, const char* fallback) {
+    if (!buffer || length == 0) {
+        lastError = TinyConfigError::BufferTooSmall;
+        return false;
+    }
+    if (!fallback) {
+        fallback = "";
+    }
+    if (!isInitialized) {
+        copyText(fallback, buffer, length);
+        lastError = TinyConfigError::FSNotRunning;
+        return false;
+    }
+    if (!isResident()) {
+        StaticJsonDocument<MemberDocSize> small;
+        std::unique_ptr<DynamicJsonDocument> large;
+        JsonDocument& member = memberDoc(small, large, true);
+        if (loadMember(key, member)) {
+            JsonVariantConst value = member.as<JsonObjectConst>()[keyChars(key)];
+            return value.isNull() ? copyDefault(keyChars(key), fallback, buffer, length)
+                                  : copyMember(value | fallback, buffer, length);
+        }
+    }
+    std::unique_ptr<DynamicJsonDocument> scratch;
+    JsonDocument* doc = openDoc(scratch);
+    if (!doc) {
+        copyText(fallback, buffer, length);
+        return false;
+    }
+    JsonVariantConst value = findMember(*doc, key);
+    return value.isNull() ? copyDefault(keyChars(key), fallback, buffer, length)
+                          : copyMember(value | fallback, buffer, length);
+}
+
+/**
+ * @brief Copies the text of a member into a buffer and sets lastError.
+ * @param text The text to copy.
+ * @param buffer The buffer to copy the text into.
+ * @param length The size of the buffer in bytes.
+ * @return true if the text was copied completely, false if it was cut.
+ */
+bool TinyConfig::copyMember(const char* text, char* buffer, size_t length) {
+    if (!copyText(text, buffer, length)) {
+        lastError = TinyConfigError::BufferTooSmall;
         return false;
     }
     lastError = TinyConfigError::None;
@@ -202,117 +2682,246 @@ bool TinyConfig::setInternal(const String& key, T value) {
 }
 
 /**
- * @brief Sets or updates an integer value in the configuration.
- * @param key The key to set.
- * @param value The integer value to set.
- * @return true if the value was set successfully, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * @brief Registers a table of defaults that getters return for keys that are not stored.
+ * @param table Array of defaults, e.g. {{"port", 80}, {"ssid", "tiny"}}. It is read in place and must outlive the instance; declare it const and PROGMEM to keep it in flash.
+ * @param count Number of entries in the table.
+ * 
+ * The table is never written to the configuration file, so the file only holds values that were set and stays small
+ * to parse. A getter returns, in this order, the stored value, the table's entry if its type matches, or the fallback
+ * passed to the getter; an int entry also serves getFloat(). Calling set() with a key stores an override, and
+ * deleting the key brings the default back. Lookups scan the table, so keep it to a few dozen entries. Pass nullptr
+ * to remove the table.
  */
-bool TinyConfig::set(const String& key, int value) {
-    return setInternal(key, value);
+void TinyConfig::registerDefaults(const TinyConfigDefault* table, size_t count) {
+    defaults = table;
+    defaultCount = table ? count : 0;
+    ++generation; // getters may return other values now
 }
 
 /**
- * @brief Sets or updates a float value in the configuration.
- * @param key The key to set.
- * @param value The float value to set.
- * @return true if the value was set successfully, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * @brief Sets whether getAll() and getAllJson() include the defaults table.
+ * @param enabled true to add the defaults of keys that are not stored, false to return only the stored values (default).
+ * @return Always true.
+ * 
+ * With defaults merged, getAll(Print&) serializes a merged copy of the configuration instead of copying the file as
+ * it is stored, and the copy needs room for all defaults on the heap.
  */
-bool TinyConfig::set(const String& key, float value) {
-    return setInternal(key, value);
+bool TinyConfig::setMergeDefaults(bool enabled) {
+    mergeDefaults = enabled;
+    ++generation;
+    return true;
 }
 
 /**
- * @brief Sets or updates a string value in the configuration.
- * @param key The key to set.
- * @param value The string value to set.
- * @return true if the value was set successfully, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * @brief Looks up a key in the defaults table.
+ * @param key The key to look up.
+ * @param entry Receives a copy of the table entry, read from flash.
+ * @return true if the table has an entry for key, false otherwise.
  */
-bool TinyConfig::set(const String& key, const String& value) {
-    return setInternal(key, value);
+bool TinyConfig::findDefault(const char* key, TinyConfigDefault& entry) const {
+    for (size_t i = 0; i < defaultCount; ++i) {
+        memcpy_P(&entry, &defaults[i], sizeof(entry));
+        if (entry.key && strcmp_P(key, entry.key) == 0) {
+            return true;
+        }
+    }
+    return false;
 }
 
 /**
- * @brief Gets an integer value from the configuration.
- * @param key The key to retrieve.
- * @param fallback The fallback value if the key does not exist or on error.
- * @return The integer value or fallback. If the key does not exist or an error occurs, the fallback value is returned.
- * 
- * Check getLastError() or getLastErrorString() for details on any errors that occur.
+ * @brief Returns the default of a key that is not stored.
+ * @tparam T The type the getter returns.
+ * @param key The key to look up.
+ * @param fallback The value to return if the table has no entry of a matching type.
+ * @return The table's entry or fallback.
  */
-int TinyConfig::getInt(const String& key, int fallback) {
-    if (!isInitialized) {
-        lastError = TinyConfigError::FSNotRunning;
-        return fallback;
+template <typename T>
+T TinyConfig::defaultOr(const char* key, T fallback) const {
+    TinyConfigDefault entry;
+    return findDefault(key, entry) ? defaultValue(entry, fallback) : fallback;
+}
+
+/**
+ * @brief Copies the default of a key that is not stored into a buffer and sets lastError.
+ * @param key The key to look up.
+ * @param fallback The text to copy if the table has no text entry for key.
+ * @param buffer The buffer to copy the text into.
+ * @param length The size of the buffer in bytes.
+ * @return true if the text was copied completely, false if it was cut.
+ */
+bool TinyConfig::copyDefault(const char* key, const char* fallback, char* buffer, size_t length) {
+    TinyConfigDefault entry;
+    if (findDefault(key, entry) && entry.type == TinyConfigEntry::Type::Text && entry.text) {
+        bool complete = copyFlashText(entry.text, buffer, length);
+        lastError = complete ? TinyConfigError::None : TinyConfigError::BufferTooSmall;
+        return complete;
     }
-    DynamicJsonDocument doc(maxFileSize);
-    if (!loadDoc(doc)) {
-        return fallback;
+    return copyMember(fallback, buffer, length);
+}
+
+/**
+ * @brief Estimates the memory a document needs to hold every entry of the defaults table.
+ * @return The size in bytes to add to the capacity of the document.
+ */
+size_t TinyConfig::defaultsSize() const {
+    size_t size = 0;
+    TinyConfigDefault entry;
+    for (size_t i = 0; i < defaultCount; ++i) {
+        memcpy_P(&entry, &defaults[i], sizeof(entry));
+        if (!entry.key) {
+            continue;
+        }
+        size += JSON_OBJECT_SIZE(1) + strlen_P(entry.key) + 1;
+        if (entry.type == TinyConfigEntry::Type::Text && entry.text) {
+            size += strlen_P(entry.text) + 1;
+        }
     }
-    lastError = TinyConfigError::None;
-    return doc[key] | fallback;
+    return size;
 }
 
 /**
- * @brief Gets a float value from the configuration.
- * @param key The key to retrieve.
- * @param fallback The fallback value if the key does not exist or on error.
- * @return The float value or fallback. If the key does not exist or an error occurs, the fallback value is returned.
- * 
- * Check getLastError() or getLastErrorString() for details on any errors that occur.
+ * @brief Adds the defaults of all keys that doc does not hold.
+ * @param doc The document to add the defaults to; it needs defaultsSize() bytes of room.
  */
-float TinyConfig::getFloat(const String& key, float fallback) {
-    if (!isInitialized) {
-        lastError = TinyConfigError::FSNotRunning;
-        return fallback;
+void TinyConfig::addDefaults(JsonDocument& doc) const {
+    TinyConfigDefault entry;
+    for (size_t i = 0; i < defaultCount; ++i) {
+        memcpy_P(&entry, &defaults[i], sizeof(entry));
+        if (!entry.key) {
+            continue;
+        }
+        String key = flashString(entry.key);
+        if (!doc[key].isNull()) {
+            continue;
+        }
+        switch (entry.type) {
+            case TinyConfigEntry::Type::Int:
+                doc[key] = entry.intValue;
+                break;
+            case TinyConfigEntry::Type::Float:
+                doc[key] = entry.floatValue;
+                break;
+            case TinyConfigEntry::Type::Text:
+                doc[key] = entry.text ? flashString(entry.text) : String();
+                break;
+        }
     }
-    DynamicJsonDocument doc(maxFileSize);
-    if (!loadDoc(doc)) {
-        return fallback;
+}
+
+/**
+ * @brief Opens the configuration document for getAll() and getAllJson().
+ * @param scratch Holds the document if it is not kept in RAM, or the merged copy.
+ * @return The document, with the defaults table merged in after setMergeDefaults(true), or nullptr on error.
+ */
+JsonDocument* TinyConfig::mergedDoc(std::unique_ptr<DynamicJsonDocument>& scratch) {
+    JsonDocument* doc = openDoc(scratch);
+    if (!doc || !mergeDefaults || defaultCount == 0) {
+        return doc;
     }
-    lastError = TinyConfigError::None;
-    return doc[key] | fallback;
+    std::unique_ptr<DynamicJsonDocument> merged(new DynamicJsonDocument(doc->memoryUsage() + defaultsSize()));
+    merged->set(*doc);
+    addDefaults(*merged);
+    scratch = std::move(merged);
+    return scratch.get();
 }
 
 /**
- * @brief Gets a string value from the configuration. 
- * @param key The key to retrieve.
- * @param fallback The fallback value if the key does not exist or on error.
- * @return The string value or fallback. If the key does not exist or an error occurs, the fallback value is returned.
+ * @brief Reads several values with a single load of the configuration.
+ * @param targets The keys, where to store their values and their fallbacks, e.g. {{"port", &port, 80}, {"ssid", ssid, sizeof(ssid)}}.
+ * @return true if the configuration was read and every string fit its buffer, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ */
+bool TinyConfig::getMany(std::initializer_list<TinyConfigTarget> targets) {
+    return getMany(targets.begin(), targets.size());
+}
+
+/**
+ * @brief Reads several values with a single load of the configuration.
+ * @param targets Array of keys, where to store their values and their fallbacks.
+ * @param count Number of targets in the array.
+ * @return true if the configuration was read and every string fit its buffer, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
  * 
- * Check getLastError() or getLastErrorString() for details on any errors that occur.
+ * Outside of cache mode every getter opens and parses the file; reading the settings at boot with one getMany()
+ * instead of one getter per key costs a single parse. Every target is always written: keys that are missing, hold
+ * a value of another type, or cannot be read get their fallback; keys that are not stored get their entry of the defaults
+ * table first, as with the single getters. Strings longer than their buffer are cut and set
+ * lastError to BufferTooSmall; the other targets are still filled.
  */
-String TinyConfig::getString(const String& key, const String& fallback) {
+bool TinyConfig::getMany(const TinyConfigTarget* targets, size_t count) {
+    std::unique_ptr<DynamicJsonDocument> scratch;
+    JsonDocument* doc = nullptr;
     if (!isInitialized) {
         lastError = TinyConfigError::FSNotRunning;
-        return fallback;
+    } else {
+        doc = openDoc(scratch);
     }
-    DynamicJsonDocument doc(maxFileSize);
-    if (!loadDoc(doc)) {
-        return fallback;
+    TinyConfigError error = doc ? TinyConfigError::None : lastError;
+    JsonObjectConst root = doc ? doc->as<JsonObjectConst>() : JsonObjectConst();
+    for (size_t i = 0; i < count; ++i) {
+        const TinyConfigTarget& target = targets[i];
+        JsonVariantConst value = root[target.key];
+        const char* fallback = target.textFallback ? target.textFallback : "";
+        TinyConfigDefault entry;
+        bool useDefault = doc && value.isNull() && findDefault(target.key, entry);
+        switch (target.type) {
+            case TinyConfigTarget::Type::Int:
+                *static_cast<int*>(target.target) =
+                    useDefault ? defaultValue(entry, target.intFallback) : value | target.intFallback;
+                break;
+            case TinyConfigTarget::Type::Float:
+                *static_cast<float*>(target.target) =
+                    useDefault ? defaultValue(entry, target.floatFallback) : value | target.floatFallback;
+                break;
+            case TinyConfigTarget::Type::String:
+                *static_cast<String*>(target.target) =
+                    useDefault ? defaultValue(entry, String(fallback)) : String(value | fallback);
+                break;
+            case TinyConfigTarget::Type::Buffer: {
+                char* buffer = static_cast<char*>(target.target);
+                bool complete;
+                if (target.length == 0) {
+                    complete = false;
+                } else if (useDefault && entry.type == TinyConfigEntry::Type::Text && entry.text) {
+                    complete = copyFlashText(entry.text, buffer, target.length);
+                } else {
+                    complete = copyText(value | fallback, buffer, target.length);
+                }
+                if (!complete && doc) {
+                    error = TinyConfigError::BufferTooSmall;
+                }
+                break;
+            }
+        }
     }
-    lastError = TinyConfigError::None;
-    return doc[key] | fallback;
+    lastError = error;
+    return error == TinyConfigError::None;
 }
 
 /**
  * @brief Gets all configuration data as a DynamicJsonDocument.
  * @return A DynamicJsonDocument representing the entire configuration.
  * 
- * This function loads the entire configuration into a DynamicJsonDocument.
+ * This function loads the entire configuration into a DynamicJsonDocument. In cache mode a copy of the cached document is returned.
+ * After setMergeDefaults(true), the defaults of keys that are not stored are added to the returned document.
  * If the filesystem is not initialized, it sets the lastError to FSNotRunning.
  * If the file cannot be loaded, it sets lastError accordingly.
  */
 DynamicJsonDocument TinyConfig::getAllJson() {
-    DynamicJsonDocument doc(maxFileSize);
     if (!isInitialized) {
         lastError = TinyConfigError::FSNotRunning;
-        return doc;
+        return DynamicJsonDocument(maxFileSize);
     }
-    if (!loadDoc(doc)) {
-        return doc;
+    std::unique_ptr<DynamicJsonDocument> scratch;
+    JsonDocument* doc = mergedDoc(scratch);
+    if (!doc) {
+        return DynamicJsonDocument(maxFileSize);
     }
     lastError = TinyConfigError::None;
-    return doc;
+    if (scratch) {
+        return std::move(*scratch);
+    }
+    DynamicJsonDocument copy(doc->memoryUsage());
+    copy.set(*doc);
+    return copy;
 }
 
 /**
@@ -329,12 +2938,13 @@ String TinyConfig::getAll(const String& fallback) {
         lastError = TinyConfigError::FSNotRunning;
         return fallback;
     }
-    DynamicJsonDocument doc(maxFileSize);
-    if (!loadDoc(doc)) {
+    std::unique_ptr<DynamicJsonDocument> scratch;
+    JsonDocument* doc = mergedDoc(scratch);
+    if (!doc) {
         return fallback;
     }
     String jsonString;
-    if (serializeJson(doc, jsonString) == 0) {
+    if (serializeJson(*doc, jsonString) == 0) {
         lastError = TinyConfigError::JsonSerializeFailed;
         return fallback;
     }
@@ -342,6 +2952,66 @@ String TinyConfig::getAll(const String& fallback) {
     return jsonString;
 }
 
+/**
+ * @brief Writes all configuration data as JSON to a Print, e.g. Serial or a web server response.
+ * @param out Where to write the JSON.
+ * @return true if the whole configuration was written, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * Unlike getAll(const String&), no String holding the whole configuration is built, so peak heap does not grow
+ * with the size of the configuration. A JSON file without header that is not kept in RAM is copied to out as it is
+ * stored, without parsing it, unless defaults are merged; otherwise the document is serialized to out through a small buffer.
+ * If out stops accepting data, lastError is JsonSerializeFailed and out holds an incomplete document.
+ */
+bool TinyConfig::getAll(Print& out) {
+    if (!isInitialized) {
+        lastError = TinyConfigError::FSNotRunning;
+        return false;
+    }
+    if (!isResident() && !atomicSave && format == TinyConfigFormat::Json && !(mergeDefaults && defaultCount > 0)) {
+        File f = openFile(configPath(format), "r");
+        if (!f) {
+            lastError = TinyConfigError::FileOpenFailed;
+            return false;
+        }
+        if (f.peek() == '{') {
+            uint8_t buffer[128];
+            bool complete = true;
+            size_t count;
+            while (complete && (count = f.read(buffer, sizeof(buffer))) > 0) {
+                complete = out.write(buffer, count) == count;
+            }
+            closeFile(f);
+            lastError = complete ? TinyConfigError::None : TinyConfigError::JsonSerializeFailed;
+            return complete;
+        }
+        closeFile(f);
+    }
+    std::unique_ptr<DynamicJsonDocument> scratch;
+    JsonDocument* doc = mergedDoc(scratch);
+    if (!doc) {
+        return false;
+    }
+    BufferedWriter writer(out);
+    if (serializeJson(*doc, writer) == 0 || !writer.finish()) {
+        lastError = TinyConfigError::JsonSerializeFailed;
+        return false;
+    }
+    lastError = TinyConfigError::None;
+    return true;
+}
+
+/**
+ * @brief Passes all configuration data as JSON to a handler, in chunks of at most 128 bytes.
+ * @param handler Called for every chunk; returning false stops the output.
+ * @return true if the whole configuration was passed to the handler, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ * 
+ * This is getAll(Print&) for sinks that are not a Print, e.g. a chunked HTTP response or an MQTT publish.
+ */
+bool TinyConfig::getAll(const TinyConfigChunkHandler& handler) {
+    ChunkWriter writer(handler);
+    return getAll(writer);
+}
+
 /**
  * @brief Deletes a key + data from the configuration.
  * @param key The key to delete.
@@ -353,22 +3023,47 @@ String TinyConfig::getAll(const String& fallback) {
  * If the file is successfully updated, it sets lastError to None.
  */
 bool TinyConfig::deleteKey(const String& key) {
+    return deleteInternal(key);
+}
+
+/**
+ * @brief Deletes a key + data from the configuration.
+ * @param key The key to delete, created with TC_KEY().
+ * @return true if the key was deleted successfully, false otherwise. On failure, check getLastError() or getLastErrorString() for details.
+ */
+bool TinyConfig::deleteKey(TinyConfigKey key) {
+    return deleteInternal(key);
+}
+
+/**
+ * @brief Internal helper to delete a key from the configuration.
+ * @tparam K The key type, String or TinyConfigKey.
+ * @param key The key to delete.
+ * @return true if the key was deleted successfully, false otherwise. If the key does not exist, lastError is None.
+ */
+template <typename K>
+bool TinyConfig::deleteInternal(const K& key) {
     if (!isInitialized) {
         lastError = TinyConfigError::FSNotRunning;
         return false;
     }
-    DynamicJsonDocument doc(maxFileSize);
-    if (!loadDoc(doc)) {
+    std::unique_ptr<DynamicJsonDocument> scratch;
+    JsonDocument* doc = openDoc(scratch);
+    if (!doc) {
         return false;
     }
-    if (!doc.containsKey(key)) {
+    if (!doc->containsKey(jsonKey(key))) {
         lastError = TinyConfigError::None;
         return false;
     }
-    doc.remove(key);
-    if (!saveDoc(doc)) {
+    ++generation;
+    doc->remove(jsonKey(key));
+    StaticJsonDocument<JSON_OBJECT_SIZE(1)> patch;
+    patch[keyChars(key)] = nullptr;
+    if (!storeDoc(*doc, 0, &patch)) {
         return false;
     }
+    notifyChanges(patch.as<JsonObjectConst>(), false);
     lastError = TinyConfigError::None;
     return true;
 }
@@ -394,27 +3089,302 @@ bool TinyConfig::deleteKeys(const std::vector<String>& keys) {
         lastError = TinyConfigError::FSNotRunning;
         return false;
     }
-    DynamicJsonDocument doc(maxFileSize);
-    if (!loadDoc(doc)) {
+    std::unique_ptr<DynamicJsonDocument> scratch;
+    JsonDocument* doc = openDoc(scratch);
+    if (!doc) {
         return false;
     }
+    ++generation;
+    DynamicJsonDocument patch(JSON_OBJECT_SIZE(keys.size()));
     bool deleted = false;
     for (const auto& key : keys) {
-        if (doc.containsKey(key)) {
-            doc.remove(key);
+        if (doc->containsKey(key)) {
+            doc->remove(key);
+            patch[key.c_str()] = nullptr;
             deleted = true;
         }
     }
     if (deleted) {
-        if (!saveDoc(doc)) {
+        if (!storeDoc(*doc, 0, &patch)) {
             return false;
         }
+        notifyChanges(patch.as<JsonObjectConst>(), false);
     }
     lastError = TinyConfigError::None;
     return deleted;
 }
 
+/**
+ * @brief Sets several values with a single file write.
+ * @param entries The keys and values, e.g. {{"ssid", ssid}, {"port", 80}, {"gain", 2.5f}}.
+ * @return true if all values were set, false otherwise. On failure nothing is changed; check getLastError() or getLastErrorString() for details.
+ * 
+ * The values are applied to one loaded document with the same size checks as set(), and the file is written once
+ * at the end, like a transaction. If a later key repeats an earlier one, the later value wins.
+ */
+bool TinyConfig::setMany(std::initializer_list<TinyConfigEntry> entries) {
+    Transaction tx = beginTransaction();
+    if (!tx.isActive()) {
+        return false;
+    }
+    for (const TinyConfigEntry& entry : entries) {
+        bool applied = false;
+        switch (entry.type) {
+            case TinyConfigEntry::Type::Int:
+                applied = tx.set(entry.key, entry.intValue);
+                break;
+            case TinyConfigEntry::Type::Float:
+                applied = tx.set(entry.key, entry.floatValue);
+                break;
+            case TinyConfigEntry::Type::Text:
+                applied = tx.set(entry.key, String(entry.text ? entry.text : ""));
+                break;
+        }
+        if (!applied) {
+            return false;
+        }
+    }
+    return tx.commit();
+}
+
+/**
+ * @brief Applies a JSON object to the configuration with a single file write.
+ * @param changes The members to set; a null value deletes the key.
+ * @return true if all changes were applied, false otherwise. On failure nothing is changed; check getLastError() or getLastErrorString() for details.
+ * 
+ * This is a merge patch on the top level, e.g. for the fields a settings form posts: members of changes replace the
+ * members of the same name, nested objects and arrays included, and all other keys are kept. Keys and strings are
+ * copied, so changes can be freed afterwards. If the result exceeds maxFileSize, it sets lastError to
+ * FileSizeTooLarge.
+ */
+bool TinyConfig::merge(JsonObjectConst changes) {
+    Transaction tx = beginTransaction();
+    if (!tx.isActive()) {
+        return false;
+    }
+    for (JsonPairConst member : changes) {
+        String key = member.key().c_str();
+        if (member.value().isNull()) {
+            tx.doc.remove(key);
+        } else if (!tx.doc[key].set(member.value())) {
+            tx.doc.garbageCollect();
+            if (!tx.doc[key].set(member.value())) {
+                lastError = TinyConfigError::FileSizeTooLarge;
+                return false;
+            }
+        }
+    }
+    return tx.commit();
+}
+
+/**
+ * @brief Calls a function whenever a key is changed through this instance.
+ * @param key The key to watch.
+ * @param handler Called with the key and its new value after set(), deleteKey(), deleteKeys(), resetConfig() or Transaction::commit().
+ * 
+ * The handler runs after the change has been stored (or buffered, in write-back mode), and gets the value directly,
+ * so nothing has to poll the configuration. The value is null if the key was deleted or the configuration reset; it
+ * is only valid during the call. Only keys whose value changed are notified: a set() or Transaction::commit() that
+ * leaves a key as it was does not call its handlers, while resetConfig() calls all of them. Changes made to
+ * the file by other instances or in other ways are not noticed. A key can have several handlers.
+ */
+void TinyConfig::onChange(const String& key, TinyConfigChangeHandler handler) {
+    changeSubscriptions.push_back({key, handler});
+}
+
+/**
+ * @brief Removes all handlers registered for a key with onChange().
+ * @param key The key that is no longer watched.
+ */
+void TinyConfig::removeOnChange(const String& key) {
+    for (size_t i = changeSubscriptions.size(); i-- > 0;) {
+        if (changeSubscriptions[i].key == key) {
+            changeSubscriptions.erase(changeSubscriptions.begin() + i);
+        }
+    }
+}
+
+/**
+ * @brief Starts a transaction that collects changes and applies them all at once.
+ * @return The new transaction. If the configuration cannot be loaded, the transaction is not active; check getLastError() or getLastErrorString() for details.
+ * 
+ * The transaction works on its own copy of the configuration, so its changes are invisible until Transaction::commit().
+ * Commit writes the file once, so it never contains only part of the changes. Changes made through TinyConfig itself
+ * while the transaction is open are overwritten by the commit.
+ * A transaction holds a document of maxFileSize bytes until it is committed, rolled back or destroyed.
+ */
+TinyConfig::Transaction TinyConfig::beginTransaction() {
+    return Transaction(*this);
+}
+
+/**
+ * @brief Creates a transaction on a copy of the owner's configuration.
+ * @param owner The TinyConfig instance the transaction belongs to.
+ */
+TinyConfig::Transaction::Transaction(TinyConfig& owner) : owner(&owner), doc(owner.maxFileSize) {
+    if (!owner.isInitialized) {
+        owner.lastError = TinyConfigError::FSNotRunning;
+        return;
+    }
+    if (owner.isResident()) {
+        std::unique_ptr<DynamicJsonDocument> scratch;
+        JsonDocument* current = owner.openDoc(scratch);
+        if (!current) {
+            return;
+        }
+        if (!doc.set(*current)) {
+            owner.lastError = TinyConfigError::FileSizeTooLarge;
+            return;
+        }
+    } else if (!owner.loadDoc(doc)) {
+        return;
+    }
+    active = true;
+    owner.lastError = TinyConfigError::None;
+}
+
+/**
+ * @brief Moves a transaction. The moved-from transaction is no longer active.
+ * @param other The transaction to move from.
+ */
+TinyConfig::Transaction::Transaction(Transaction&& other)
+    : owner(other.owner), doc(std::move(other.doc)), active(other.active) {
+    other.active = false;
+}
+
+/**
+ * @brief Internal helper to set a value in the transaction.
+ * @tparam T The type of the value to set.
+ * @param key The key to set.
+ * @param value The value to set.
+ * @return true if the value was set, false otherwise. On failure, check the owner's getLastError() or getLastErrorString() for details.
+ * 
+ * The same size limits as TinyConfig::set() apply, and a rejected value leaves the transaction unchanged.
+ */
+template <typename T>
+bool TinyConfig::Transaction::setInternal(const String& key, T value) {
+    if (!active) {
+        owner->lastError = TinyConfigError::TransactionNotActive;
+        return false;
+    }
+    size_t fileSize = 0;
+    if (!owner->fitsAfterSet(doc, key, value, fileSize)) {
+        return false;
+    }
+    if (!doc[key].set(value)) {
+        owner->lastError = TinyConfigError::FileSizeTooLarge;
+        return false;
+    }
+    owner->lastError = TinyConfigError::None;
+    return true;
+}
+
+/**
+ * @brief Sets or updates an integer value in the transaction.
+ * @param key The key to set.
+ * @param value The integer value to set.
+ * @return true if the value was set, false otherwise.
+ */
+bool TinyConfig::Transaction::set(const String& key, int value) {
+    return setInternal(key, value);
+}
+
+/**
+ * @brief Sets or updates a float value in the transaction.
+ * @param key The key to set.
+ * @param value The float value to set.
+ * @return true if the value was set, false otherwise.
+ */
+bool TinyConfig::Transaction::set(const String& key, float value) {
+    return setInternal(key, value);
+}
+
+/**
+ * @brief Sets or updates a string value in the transaction.
+ * @param key The key to set.
+ * @param value The string value to set.
+ * @return true if the value was set, false otherwise.
+ */
+bool TinyConfig::Transaction::set(const String& key, const String& value) {
+    return setInternal(key, value);
+}
+
+/**
+ * @brief Deletes a key + data in the transaction.
+ * @param key The key to delete.
+ * @return true if the key existed and was deleted, false otherwise.
+ */
+bool TinyConfig::Transaction::deleteKey(const String& key) {
+    if (!active) {
+        owner->lastError = TinyConfigError::TransactionNotActive;
+        return false;
+    }
+    owner->lastError = TinyConfigError::None;
+    if (!doc.containsKey(key)) {
+        return false;
+    }
+    doc.remove(key);
+    return true;
+}
+
+/**
+ * @brief Applies all changes of the transaction with a single file write.
+ * @return true if the changes were applied, false otherwise. On failure, check the owner's getLastError() or getLastErrorString() for details.
+ * 
+ * In write-back mode the changes are applied to the document in RAM and written by the next TinyConfig::commit().
+ * The onChange() handlers of the keys whose value changed are called with the new value, null if the key was deleted.
+ * If writing fails, the transaction stays active so the commit can be retried or rolled back.
+ */
+bool TinyConfig::Transaction::commit() {
+    if (!active) {
+        owner->lastError = TinyConfigError::TransactionNotActive;
+        return false;
+    }
+    if (!owner->isInitialized) {
+        owner->lastError = TinyConfigError::FSNotRunning;
+        return false;
+    }
+    std::vector<bool> changed = owner->changedKeys(doc);
+    if (!owner->replaceDoc(doc)) {
+        return false;
+    }
+    active = false;
+    if (!changed.empty()) {
+        std::unique_ptr<DynamicJsonDocument> scratch;
+        JsonDocument* current = owner->isResident() ? owner->openDoc(scratch) : &doc;
+        if (current) {
+            owner->notifyChanges(current->as<JsonObjectConst>(), true, &changed);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Discards all changes of the transaction.
+ */
+void TinyConfig::Transaction::rollback() {
+    active = false;
+    doc.clear();
+}
+
+/**
+ * @brief Checks whether the transaction can still be changed and committed.
+ * @return true until the transaction is committed or rolled back.
+ */
+bool TinyConfig::Transaction::isActive() const {
+    return active;
+}
+
 // Explicit template instantiations
-template bool TinyConfig::setInternal<int>(const String&, int);
-template bool TinyConfig::setInternal<float>(const String&, float);
-template bool TinyConfig::setInternal<String>(const String&, String);
+template bool TinyConfig::setInternal<String, int>(const String&, int);
+template bool TinyConfig::setInternal<String, float>(const String&, float);
+template bool TinyConfig::setInternal<String, String>(const String&, String);
+template bool TinyConfig::setInternal<TinyConfigKey, int>(const TinyConfigKey&, int);
+template bool TinyConfig::setInternal<TinyConfigKey, float>(const TinyConfigKey&, float);
+template bool TinyConfig::setInternal<TinyConfigKey, String>(const TinyConfigKey&, String);
+template int TinyConfig::getInternal<String, int>(const String&, int);
+template float TinyConfig::getInternal<String, float>(const String&, float);
+template String TinyConfig::getInternal<String, String>(const String&, String);
+template int TinyConfig::getInternal<TinyConfigKey, int>(const TinyConfigKey&, int);
+template float TinyConfig::getInternal<TinyConfigKey, float>(const TinyConfigKey&, float);
+template String TinyConfig::getInternal<TinyConfigKey, String>(const TinyConfigKey&, String);
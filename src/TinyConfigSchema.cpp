@@ -0,0 +1,121 @@
+// Licensed under Apache License, Version 2.0
+// SPDX-License-Identifier: Apache-2.0
+// http://www.apache.org/licenses/LICENSE-2.0
+// © 2025 Lennart Gutjahr
+
+#include "TinyConfigSchema.h"
+using namespace ArduinoJson;
+
+namespace {
+
+// Copies a string into a field's char array, cutting it if needed.
+void copyString(char* target, size_t size, const char* value) {
+    if (!value) {
+        value = "";
+    }
+    strncpy(target, value, size - 1);
+    target[size - 1] = '\0';
+}
+
+} // namespace
+
+/**
+ * @brief Sets every field of a settings struct to its default value.
+ * @param fields The schema.
+ * @param count Number of fields in the schema.
+ * @param data The settings struct.
+ */
+void tinyConfigApplyDefaults(const TinyConfigField* fields, size_t count, void* data) {
+    uint8_t* base = static_cast<uint8_t*>(data);
+    for (size_t i = 0; i < count; ++i) {
+        const TinyConfigField& field = fields[i];
+        void* member = base + field.offset;
+        switch (field.type) {
+            case TinyConfigFieldType::Int:
+                *static_cast<int*>(member) = field.intDefault;
+                break;
+            case TinyConfigFieldType::Float:
+                *static_cast<float*>(member) = field.floatDefault;
+                break;
+            case TinyConfigFieldType::String:
+                copyString(static_cast<char*>(member), field.size, field.stringDefault);
+                break;
+        }
+    }
+}
+
+/**
+ * @brief Fills a settings struct from the configuration.
+ * @param config The configuration to read.
+ * @param fields The schema.
+ * @param count Number of fields in the schema.
+ * @param data The settings struct.
+ * @return true if the configuration was read, false otherwise. On failure, check getLastError() or getLastErrorString() of config for details.
+ * 
+ * The configuration is read once for all fields. Keys that are missing or hold a value of another type get the
+ * default of their field. If the configuration cannot be read, every field gets its default.
+ */
+bool tinyConfigLoadFields(TinyConfig& config, const TinyConfigField* fields, size_t count, void* data) {
+    DynamicJsonDocument doc = config.getAllJson();
+    if (config.getLastError() != TinyConfigError::None) {
+        tinyConfigApplyDefaults(fields, count, data);
+        return false;
+    }
+    uint8_t* base = static_cast<uint8_t*>(data);
+    for (size_t i = 0; i < count; ++i) {
+        const TinyConfigField& field = fields[i];
+        JsonVariantConst value = doc[field.key];
+        void* member = base + field.offset;
+        switch (field.type) {
+            case TinyConfigFieldType::Int:
+                *static_cast<int*>(member) = value | field.intDefault;
+                break;
+            case TinyConfigFieldType::Float:
+                *static_cast<float*>(member) = value | field.floatDefault;
+                break;
+            case TinyConfigFieldType::String:
+                copyString(static_cast<char*>(member), field.size, value.is<const char*>() ? value.as<const char*>() : field.stringDefault);
+                break;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Writes a settings struct to the configuration.
+ * @param config The configuration to write.
+ * @param fields The schema.
+ * @param count Number of fields in the schema.
+ * @param data The settings struct.
+ * @return true if all fields were written, false otherwise. On failure, nothing is changed; check getLastError() or getLastErrorString() of config for details.
+ * 
+ * All fields are written in one transaction, so the file is written once and never holds only some of them.
+ */
+bool tinyConfigSaveFields(TinyConfig& config, const TinyConfigField* fields, size_t count, const void* data) {
+    const uint8_t* base = static_cast<const uint8_t*>(data);
+    TinyConfig::Transaction tx = config.beginTransaction();
+    if (!tx.isActive()) {
+        return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        const TinyConfigField& field = fields[i];
+        const void* member = base + field.offset;
+        bool ok = false;
+        switch (field.type) {
+            case TinyConfigFieldType::Int:
+                ok = tx.set(field.key, *static_cast<const int*>(member));
+                break;
+            case TinyConfigFieldType::Float:
+                ok = tx.set(field.key, *static_cast<const float*>(member));
+                break;
+            case TinyConfigFieldType::String:
+                ok = tx.set(field.key, String(static_cast<const char*>(member)));
+                break;
+        }
+        if (!ok) {
+            tx.rollback();
+            return false;
+        }
+    }
+    return tx.commit();
+}
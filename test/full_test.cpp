@@ -1,6 +1,10 @@
 #include <Arduino.h>
 #include <unity.h>
 #include "TinyConfig.h"
+#include "TinyConfigSchema.h"
+#ifdef TINYCONFIG_HOST
+#include <HostHeap.h>
+#endif
 
 TinyConfig tc;
 
@@ -109,6 +113,1053 @@ void test_deleteKeys_vector() {
     TEST_ASSERT_EQUAL(0, tc.getInt("z", 0));
 }
 
+void test_cache_mode() {
+    tc.resetConfig();
+    TEST_ASSERT_TRUE(tc.setCacheMode(true));
+    TEST_ASSERT_TRUE(tc.set("cached", 7));
+    TEST_ASSERT_EQUAL(7, tc.getInt("cached", 0));
+
+    // Getters are served from RAM, so changes behind TinyConfig's back are not seen.
+    File f = LittleFS.open("/config.json", "w");
+    f.print("{\"cached\":8}");
+    f.close();
+    TEST_ASSERT_EQUAL(7, tc.getInt("cached", 0));
+
+    TEST_ASSERT_TRUE(tc.set("other", 2.5f));
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 2.5f, tc.getFloat("other", 0.0f));
+    TEST_ASSERT_TRUE(tc.deleteKey("cached"));
+    TEST_ASSERT_EQUAL(0, tc.getInt("cached", 0));
+    TEST_ASSERT_TRUE(tc.resetConfig());
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 0.0f, tc.getFloat("other", 0.0f));
+    TEST_ASSERT_EQUAL_STRING("{}", tc.getAll().c_str());
+
+    // The file is parsed in StartTC(), so a corrupt file is reported there.
+    TEST_ASSERT_TRUE(tc.StopTC());
+    TEST_ASSERT_TRUE(LittleFS.begin());
+    f = LittleFS.open("/config.json", "w");
+    f.print("{\"cached\":");
+    f.close();
+    TEST_ASSERT_FALSE(tc.StartTC());
+    TEST_ASSERT_EQUAL(TinyConfigError::JsonParseFailed, tc.getLastError());
+    TEST_ASSERT_TRUE(tc.resetConfig());
+    TEST_ASSERT_TRUE(tc.StartTC());
+    TEST_ASSERT_EQUAL(0, tc.getInt("cached", 0));
+
+    TEST_ASSERT_TRUE(tc.setCacheMode(false));
+}
+
+void test_write_back() {
+    tc.resetConfig();
+    TEST_ASSERT_TRUE(tc.setWriteBack(true));
+    TEST_ASSERT_TRUE(tc.set("wb_a", 1));
+    TEST_ASSERT_TRUE(tc.set("wb_b", String("two")));
+    TEST_ASSERT_TRUE(tc.isDirty());
+    TEST_ASSERT_EQUAL(1, tc.getInt("wb_a", 0));
+    TEST_ASSERT_EQUAL_STRING("two", tc.getString("wb_b", "").c_str());
+
+    File f = LittleFS.open("/config.json", "r");
+    TEST_ASSERT_EQUAL_STRING("{}", f.readString().c_str());
+    f.close();
+
+    // A rejected value must not throw away the pending changes.
+    String big = "";
+    for (int i = 0; i < 3000; ++i) big += 'A';
+    TEST_ASSERT_FALSE(tc.set("wb_big", big));
+    TEST_ASSERT_EQUAL(TinyConfigError::FileSizeTooLarge, tc.getLastError());
+    TEST_ASSERT_EQUAL(1, tc.getInt("wb_a", 0));
+
+    TEST_ASSERT_TRUE(tc.commit());
+    TEST_ASSERT_FALSE(tc.isDirty());
+    f = LittleFS.open("/config.json", "r");
+    TEST_ASSERT_TRUE(f.readString().indexOf("\"wb_a\":1") != -1);
+    f.close();
+
+    TEST_ASSERT_TRUE(tc.deleteKey("wb_a"));
+    TEST_ASSERT_TRUE(tc.set("wb_c", 3));
+    TEST_ASSERT_TRUE(tc.StopTC());
+    TEST_ASSERT_TRUE(tc.StartTC());
+    TEST_ASSERT_EQUAL(0, tc.getInt("wb_a", 0));
+    TEST_ASSERT_EQUAL(3, tc.getInt("wb_c", 0));
+    TEST_ASSERT_TRUE(tc.setWriteBack(false));
+}
+
+void test_transaction() {
+    tc.resetConfig();
+    tc.set("keep", 1);
+    TinyConfig::Transaction tx = tc.beginTransaction();
+    TEST_ASSERT_TRUE(tx.isActive());
+    TEST_ASSERT_TRUE(tx.set("wifi_ssid", String("net")));
+    TEST_ASSERT_TRUE(tx.set("wifi_pass", String("secret")));
+    TEST_ASSERT_TRUE(tx.set("gain", 1.5f));
+    TEST_ASSERT_TRUE(tx.deleteKey("keep"));
+
+    // Nothing is visible before commit.
+    TEST_ASSERT_EQUAL_STRING("", tc.getString("wifi_ssid", "").c_str());
+    TEST_ASSERT_EQUAL(1, tc.getInt("keep", 0));
+
+    TEST_ASSERT_TRUE(tx.commit());
+    TEST_ASSERT_FALSE(tx.isActive());
+    TEST_ASSERT_EQUAL_STRING("net", tc.getString("wifi_ssid", "").c_str());
+    TEST_ASSERT_EQUAL_STRING("secret", tc.getString("wifi_pass", "").c_str());
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 1.5f, tc.getFloat("gain", 0.0f));
+    TEST_ASSERT_EQUAL(0, tc.getInt("keep", 0));
+
+    TEST_ASSERT_FALSE(tx.commit());
+    TEST_ASSERT_EQUAL(TinyConfigError::TransactionNotActive, tc.getLastError());
+}
+
+void test_transaction_rollback() {
+    tc.resetConfig();
+    TEST_ASSERT_TRUE(tc.setCacheMode(true));
+    tc.set("ip", String("10.0.0.2"));
+    TinyConfig::Transaction tx = tc.beginTransaction();
+    TEST_ASSERT_TRUE(tx.set("ip", String("10.0.0.3")));
+    TEST_ASSERT_TRUE(tx.set("mask", String("255.255.255.0")));
+    tx.rollback();
+    TEST_ASSERT_FALSE(tx.isActive());
+    TEST_ASSERT_FALSE(tx.set("ip", String("10.0.0.4")));
+    TEST_ASSERT_FALSE(tx.commit());
+    TEST_ASSERT_EQUAL_STRING("10.0.0.2", tc.getString("ip", "").c_str());
+    TEST_ASSERT_EQUAL_STRING("", tc.getString("mask", "").c_str());
+    TEST_ASSERT_TRUE(tc.setCacheMode(false));
+}
+
+void test_stats() {
+    tc.resetConfig();
+    tc.resetStats();
+    TEST_ASSERT_TRUE(tc.set("count", 1));
+    const TinyConfigStats& stats = tc.getStats();
+    TEST_ASSERT_EQUAL(1, stats.loadCount);
+    TEST_ASSERT_EQUAL(1, stats.saveCount);
+    TEST_ASSERT_EQUAL(1, stats.flashWrites);
+    TEST_ASSERT_EQUAL(strlen("{\"count\":1}"), stats.bytesSerialized);
+    TEST_ASSERT_EQUAL(2, stats.bytesParsed);
+    TEST_ASSERT_EQUAL(1, tc.getInt("count", 0));
+    TEST_ASSERT_EQUAL(2, stats.loadCount);
+    TEST_ASSERT_LESS_OR_EQUAL(stats.parseMicros, stats.parseMaxMicros);
+    TEST_ASSERT_LESS_OR_EQUAL(stats.fsMicros, stats.fsMaxMicros);
+
+    TEST_ASSERT_TRUE(tc.setCacheMode(true));
+    tc.resetStats();
+    TEST_ASSERT_EQUAL(1, tc.getInt("count", 0));
+    TEST_ASSERT_EQUAL(0, stats.loadCount);
+    TEST_ASSERT_EQUAL(0, stats.flashWrites);
+    TEST_ASSERT_TRUE(tc.setCacheMode(false));
+}
+
+void test_size_limit_cached() {
+    // Quotes are escaped in the file, so the file size limit is reached before the document is full.
+    String quotes = "";
+    for (int i = 0; i < 60; ++i) quotes += '"';
+    tc.resetConfig();
+    TEST_ASSERT_TRUE(tc.setCacheMode(true));
+    TEST_ASSERT_TRUE(tc.setMaxFileSize(256));
+    TEST_ASSERT_TRUE(tc.set("a", quotes));          // {"a":"<120>"} = 128 bytes
+    TEST_ASSERT_TRUE(tc.set("c", quotes));          // ,"c":"<120>" = 255 bytes
+    TEST_ASSERT_TRUE(tc.set("c", quotes + "x"));    // 256 bytes
+    TEST_ASSERT_FALSE(tc.set("c", quotes + "xx"));  // 257 bytes
+    TEST_ASSERT_EQUAL(TinyConfigError::FileSizeTooLarge, tc.getLastError());
+    File f = LittleFS.open("/config.json", "r");
+    TEST_ASSERT_EQUAL(256, f.size());
+    f.close();
+
+    TEST_ASSERT_TRUE(tc.setWriteBack(true));
+    TEST_ASSERT_TRUE(tc.deleteKey("a"));            // {"c":"<121>"} = 129 bytes
+    TEST_ASSERT_TRUE(tc.set("b", quotes));          // ,"b":"<120>" = 256 bytes
+    TEST_ASSERT_FALSE(tc.set("b", quotes + "\""));
+    TEST_ASSERT_TRUE(tc.setWriteBack(false));
+    f = LittleFS.open("/config.json", "r");
+    TEST_ASSERT_EQUAL(256, f.size());
+    f.close();
+    TEST_ASSERT_TRUE(tc.setMaxFileSize(2048));
+    TEST_ASSERT_TRUE(tc.setCacheMode(false));
+}
+
+void test_log_mode() {
+    tc.resetConfig();
+    TEST_ASSERT_TRUE(tc.setLogMode(true));
+    TEST_ASSERT_TRUE(tc.set("ssid", String("home")));
+    TEST_ASSERT_TRUE(tc.set("port", 80));
+    TEST_ASSERT_TRUE(tc.set("port", 8080));
+    TEST_ASSERT_TRUE(tc.deleteKey("ssid"));
+    File f = LittleFS.open("/config.json", "r");
+    TEST_ASSERT_EQUAL_STRING("{}", f.readString().c_str());
+    f.close();
+    TEST_ASSERT_TRUE(LittleFS.exists("/config.log"));
+    TEST_ASSERT_EQUAL(4, tc.getStats().logAppends);
+
+    // The log is replayed on start; a partial record at its end is dropped.
+    TEST_ASSERT_TRUE(tc.StopTC());
+    TEST_ASSERT_TRUE(LittleFS.begin());
+    f = LittleFS.open("/config.log", "a");
+    f.print("{\"port\":1");
+    f.close();
+    TEST_ASSERT_TRUE(tc.StartTC());
+    TEST_ASSERT_EQUAL(8080, tc.getInt("port", 0));
+    TEST_ASSERT_EQUAL_STRING("", tc.getString("ssid", "").c_str());
+    TEST_ASSERT_FALSE(LittleFS.exists("/config.log"));
+    TEST_ASSERT_TRUE(tc.set("mode", 2));
+    TEST_ASSERT_TRUE(tc.StopTC());
+    TEST_ASSERT_TRUE(tc.StartTC());
+    TEST_ASSERT_EQUAL(2, tc.getInt("mode", 0));
+
+    // An interrupted snapshot is discarded while the log still exists.
+    TEST_ASSERT_TRUE(tc.StopTC());
+    TEST_ASSERT_TRUE(LittleFS.begin());
+    f = LittleFS.open("/config.tmp", "w");
+    f.print("{\"mode\":");
+    f.close();
+    TEST_ASSERT_TRUE(tc.StartTC());
+    TEST_ASSERT_EQUAL(2, tc.getInt("mode", 0));
+    TEST_ASSERT_FALSE(LittleFS.exists("/config.tmp"));
+
+    TEST_ASSERT_TRUE(tc.setCompactThreshold(64));
+    for (int i = 0; i < 20; ++i) {
+        TEST_ASSERT_TRUE(tc.set("count", i));
+    }
+    TEST_ASSERT_GREATER_THAN(0, tc.getStats().compactions);
+    f = LittleFS.open("/config.log", "r");
+    TEST_ASSERT_TRUE(!f || f.size() <= 64);
+    f.close();
+
+    TEST_ASSERT_TRUE(tc.setLogMode(false));
+    TEST_ASSERT_FALSE(LittleFS.exists("/config.log"));
+    TEST_ASSERT_EQUAL(19, tc.getInt("count", 0));
+    TEST_ASSERT_EQUAL(8080, tc.getInt("port", 0));
+    TEST_ASSERT_TRUE(tc.setCompactThreshold(2048));
+}
+
+void test_msgpack_format() {
+    tc.resetConfig();
+    tc.set("offset", 1.5f);
+    tc.set("name", String("sensor"));
+    TEST_ASSERT_TRUE(tc.StopTC());
+    TEST_ASSERT_TRUE(tc.setFormat(TinyConfigFormat::MessagePack));
+    TEST_ASSERT_TRUE(tc.StartTC());
+    TEST_ASSERT_FALSE(LittleFS.exists("/config.json"));
+    File f = LittleFS.open("/config.msgpack", "r");
+    TEST_ASSERT_EQUAL(0x82, f.read()); // map with 2 members
+    f.close();
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 1.5f, tc.getFloat("offset", 0.0f));
+    TEST_ASSERT_EQUAL_STRING("sensor", tc.getString("name", "").c_str());
+    TEST_ASSERT_TRUE(tc.set("gain", 0.25f));
+    TEST_ASSERT_TRUE(tc.deleteKey("name"));
+    TEST_ASSERT_EQUAL_STRING("{\"offset\":1.5,\"gain\":0.25}", tc.getAll().c_str());
+
+    TEST_ASSERT_TRUE(tc.set("x", 1));
+    f = LittleFS.open("/config.msgpack", "r");
+    TEST_ASSERT_EQUAL(26, f.size());             // the same configuration as JSON takes 32 bytes
+    f.close();
+
+    TEST_ASSERT_TRUE(tc.setFormat(TinyConfigFormat::Json));
+    TEST_ASSERT_FALSE(LittleFS.exists("/config.msgpack"));
+    f = LittleFS.open("/config.json", "r");
+    TEST_ASSERT_EQUAL_STRING("{\"offset\":1.5,\"gain\":0.25,\"x\":1}", f.readString().c_str());
+    f.close();
+}
+
+struct NetSettings {
+    int port;
+    float gain;
+    char host[8];
+};
+
+constexpr TinyConfigField netFields[] = {
+    TC_FIELD(NetSettings, port, 80),
+    TC_FIELD(NetSettings, gain, 1.5f),
+    TC_FIELD_KEY(NetSettings, host, "hostname", "esp"),
+};
+
+void test_schema() {
+    tc.resetConfig();
+    TinyConfigSchema<NetSettings, 3> net(tc, netFields);
+    TEST_ASSERT_EQUAL(80, net->port);
+    TEST_ASSERT_TRUE(net.load());
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 1.5f, net->gain);
+    TEST_ASSERT_EQUAL_STRING("esp", net->host);
+
+    tc.set("port", 8080);
+    tc.set("gain", String("loud"));
+    tc.set("hostname", String("kitchen-sensor"));
+    TEST_ASSERT_TRUE(net.load());
+    TEST_ASSERT_EQUAL(8080, net->port);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 1.5f, net->gain);
+    TEST_ASSERT_EQUAL_STRING("kitchen", net->host);
+
+    net->port = 443;
+    net->gain = 0.5f;
+    strcpy(net->host, "attic");
+    tc.resetStats();
+    TEST_ASSERT_TRUE(net.save());
+    TEST_ASSERT_EQUAL(1, tc.getStats().flashWrites);
+    TEST_ASSERT_EQUAL(443, tc.getInt("port", 0));
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 0.5f, tc.getFloat("gain", 0.0f));
+    TEST_ASSERT_EQUAL_STRING("attic", tc.getString("hostname", "").c_str());
+
+    TinyConfig idle("idle");
+    TinyConfigSchema<NetSettings, 3> idleNet(idle, netFields);
+    TEST_ASSERT_FALSE(idleNet.save());
+    TEST_ASSERT_EQUAL(TinyConfigError::FSNotRunning, idle.getLastError());
+}
+
+static_assert(TC_KEY("").hash == 2166136261u, "TC_KEY must hash at compile time");
+
+void test_key_handles() {
+    tc.resetConfig();
+    TEST_ASSERT_TRUE(tc.set(TC_KEY("boot"), 3));
+    TEST_ASSERT_TRUE(tc.set(TC_KEY("gain"), 0.25f));
+    TEST_ASSERT_TRUE(tc.set(TC_KEY("ssid"), String("net")));
+    TEST_ASSERT_EQUAL(3, tc.getInt(TC_KEY("boot"), 0));
+    TEST_ASSERT_EQUAL(3, tc.getInt("boot", 0));
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 0.25f, tc.getFloat(TC_KEY("gain"), 0.0f));
+    TEST_ASSERT_EQUAL_STRING("net", tc.getString(TC_KEY("ssid"), "").c_str());
+    TEST_ASSERT_TRUE(tc.deleteKey(TC_KEY("ssid")));
+    TEST_ASSERT_EQUAL_STRING("none", tc.getString(TC_KEY("ssid"), "none").c_str());
+
+    tc.setCacheMode(true);
+    TEST_ASSERT_EQUAL(3, tc.getInt(TC_KEY("boot"), 0));
+    TEST_ASSERT_EQUAL(3, tc.getInt(TC_KEY("boot"), 0));
+    tc.set("boot", 4);
+    TEST_ASSERT_EQUAL(4, tc.getInt(TC_KEY("boot"), 0));
+    tc.deleteKey("boot");
+    TEST_ASSERT_EQUAL(-1, tc.getInt(TC_KEY("boot"), -1));
+    tc.set(TC_KEY("boot"), 5);
+    TEST_ASSERT_EQUAL(5, tc.getInt(TC_KEY("boot"), 0));
+    tc.resetConfig();
+    TEST_ASSERT_EQUAL(-1, tc.getInt(TC_KEY("boot"), -1));
+    tc.setCacheMode(false);
+}
+
+void test_buffer_getters() {
+    tc.resetConfig();
+    tc.set("ssid", String("MyNetwork"));
+    char buf[16];
+    TEST_ASSERT_TRUE(tc.getString("ssid", buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_STRING("MyNetwork", buf);
+    TEST_ASSERT_TRUE(tc.getString(TC_KEY("missing"), buf, sizeof(buf), "none"));
+    TEST_ASSERT_EQUAL_STRING("none", buf);
+    char small[4];
+    TEST_ASSERT_FALSE(tc.getString(TC_KEY("ssid"), small, sizeof(small)));
+    TEST_ASSERT_EQUAL(TinyConfigError::BufferTooSmall, tc.getLastError());
+    TEST_ASSERT_EQUAL_STRING("MyN", small);
+
+    tc.setReuseParseBuffer(true);
+    TEST_ASSERT_TRUE(tc.set("boot", 7));
+    TEST_ASSERT_EQUAL(7, tc.getInt("boot", 0));
+    TEST_ASSERT_TRUE(tc.getString("ssid", buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_STRING("MyNetwork", buf);
+    tc.setReuseParseBuffer(false);
+
+#ifdef TINYCONFIG_HOST
+    // Steady-state reads from the cached document must not touch the heap.
+    tc.setCacheMode(true);
+    tc.getInt(TC_KEY("boot"), 0);
+    size_t allocations = hostHeapStats().allocations;
+    for (int i = 0; i < 10; ++i) {
+        TEST_ASSERT_EQUAL(7, tc.getInt(TC_KEY("boot"), 0));
+        TEST_ASSERT_TRUE(tc.getString(TC_KEY("ssid"), buf, sizeof(buf)));
+        tc.getFloat(TC_KEY("gain"), 1.0f);
+    }
+    TEST_ASSERT_EQUAL(allocations, hostHeapStats().allocations);
+    TEST_ASSERT_EQUAL_STRING("MyNetwork", buf);
+    tc.setCacheMode(false);
+#endif
+}
+
+class StringPrint : public Print {
+public:
+    size_t write(uint8_t c) override {
+        text += static_cast<char>(c);
+        return 1;
+    }
+    using Print::write;
+    String text;
+};
+
+void test_getAll_stream() {
+    tc.resetConfig();
+    for (int i = 0; i < 30; ++i) {
+        tc.set("key" + String(i), String("value") + String(i));
+    }
+    String expected = tc.getAll();
+
+    StringPrint out;
+    TEST_ASSERT_TRUE(tc.getAll(out));
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), out.text.c_str());
+
+    String chunked;
+    size_t chunks = 0;
+    TEST_ASSERT_TRUE(tc.getAll([&](const uint8_t* data, size_t length) {
+        TEST_ASSERT_TRUE(length <= 128);
+        chunked.concat(reinterpret_cast<const char*>(data), length);
+        chunks++;
+        return true;
+    }));
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), chunked.c_str());
+    TEST_ASSERT_TRUE(chunks > 1);
+    TEST_ASSERT_FALSE(tc.getAll([](const uint8_t*, size_t) { return false; }));
+    TEST_ASSERT_EQUAL(TinyConfigError::JsonSerializeFailed, tc.getLastError());
+
+    tc.setCacheMode(true);
+    StringPrint cached;
+    TEST_ASSERT_TRUE(tc.getAll(cached));
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), cached.text.c_str());
+    tc.setCacheMode(false);
+
+#ifdef TINYCONFIG_HOST
+    // The file is copied through a stack buffer, so peak heap does not grow with the config size.
+    size_t peaks[2];
+    for (size_t& peak : peaks) {
+        size_t inUse = hostHeapStats().inUse;
+        hostHeapResetPeak();
+        TEST_ASSERT_TRUE(tc.getAll([](const uint8_t*, size_t) { return true; }));
+        peak = hostHeapStats().peak - inUse;
+        for (int i = 30; i < 60; ++i) {
+            tc.set("key" + String(i), String("value") + String(i));
+        }
+    }
+    TEST_ASSERT_EQUAL(peaks[0], peaks[1]);
+#endif
+}
+
+void test_atomic_save() {
+    tc.resetConfig();
+    tc.set("a", 1);
+    TEST_ASSERT_TRUE(tc.setAtomicSave(true));
+    TEST_ASSERT_FALSE(LittleFS.exists("/config.json"));
+    TEST_ASSERT_TRUE(LittleFS.exists("/config.a"));
+    TEST_ASSERT_EQUAL(1, tc.getInt("a", 0));
+    TEST_ASSERT_TRUE(tc.set("b", 2));
+    TEST_ASSERT_TRUE(LittleFS.exists("/config.b"));
+    TEST_ASSERT_EQUAL(2, tc.getInt("b", 0));
+
+    // A copy cut off while it was written is ignored; the older copy is used.
+    TEST_ASSERT_TRUE(tc.StopTC());
+    TEST_ASSERT_TRUE(LittleFS.begin());
+    File f = LittleFS.open("/config.b", "w");
+    f.print("{\"b\":");
+    f.close();
+    TEST_ASSERT_TRUE(tc.StartTC());
+    TEST_ASSERT_EQUAL(1, tc.getInt("a", 0));
+    TEST_ASSERT_EQUAL(-1, tc.getInt("b", -1));
+
+    // A copy with a wrong checksum is detected on load.
+    TEST_ASSERT_TRUE(tc.set("c", 3));
+    TEST_ASSERT_EQUAL(3, tc.getInt("c", 0));
+    TEST_ASSERT_TRUE(tc.StopTC());
+    TEST_ASSERT_TRUE(LittleFS.begin());
+    f = LittleFS.open("/config.b", "r");
+    uint8_t content[64];
+    size_t length = f.read(content, sizeof(content));
+    f.close();
+    TEST_ASSERT_EQUAL('3', content[length - 2]);
+    content[length - 2] = '4';
+    f = LittleFS.open("/config.b", "w");
+    f.write(content, length);
+    f.close();
+    TEST_ASSERT_TRUE(tc.StartTC());
+    TEST_ASSERT_EQUAL(-1, tc.getInt("c", -1));
+    TEST_ASSERT_EQUAL(1, tc.getInt("a", 0));
+    TEST_ASSERT_TRUE(tc.set("d", 4));
+    TEST_ASSERT_EQUAL(4, tc.getInt("d", 0));
+
+    // A torn copy that claims a newer generation: a restart goes straight to the copy used last, a fresh instance
+    // picks the torn copy and falls back to the intact one when the CRC does not match.
+    TEST_ASSERT_TRUE(tc.StopTC());
+    TEST_ASSERT_TRUE(LittleFS.begin());
+    uint8_t copies[2][64];
+    size_t lengths[2];
+    const char* const copyNames[2] = {"/config.a", "/config.b"};
+    for (int i = 0; i < 2; ++i) {
+        f = LittleFS.open(copyNames[i], "r");
+        lengths[i] = f.read(copies[i], sizeof(copies[i]));
+        f.close();
+    }
+    int newest = copies[1][4] > copies[0][4] ? 1 : 0;
+    copies[newest][4]++;
+    copies[newest][lengths[newest] - 2] = '5';
+    f = LittleFS.open(copyNames[newest ^ 1], "w");
+    f.write(copies[newest], lengths[newest]);
+    f.close();
+    TEST_ASSERT_TRUE(tc.StartTC());
+    tc.resetStats();
+    TEST_ASSERT_EQUAL(4, tc.getInt("d", 0));
+    TEST_ASSERT_EQUAL(1, tc.getStats().loadCount);
+    TEST_ASSERT_TRUE(tc.StopTC());
+    {
+        TinyConfig fresh;
+        TEST_ASSERT_TRUE(fresh.setAtomicSave(true));
+        TEST_ASSERT_TRUE(fresh.StartTC());
+        TEST_ASSERT_EQUAL(4, fresh.getInt("d", 0));
+        TEST_ASSERT_EQUAL(2, fresh.getStats().loadCount);
+        TEST_ASSERT_TRUE(fresh.StopTC());
+    }
+    TEST_ASSERT_TRUE(tc.StartTC());
+
+    // In log mode snapshots are written as copies.
+    TEST_ASSERT_TRUE(tc.setLogMode(true));
+    TEST_ASSERT_TRUE(tc.set("e", 5));
+    TEST_ASSERT_TRUE(tc.StopTC());
+    TEST_ASSERT_TRUE(tc.StartTC());
+    TEST_ASSERT_EQUAL(5, tc.getInt("e", 0));
+    TEST_ASSERT_TRUE(tc.compact());
+    TEST_ASSERT_FALSE(LittleFS.exists("/config.log"));
+    TEST_ASSERT_TRUE(tc.setLogMode(false));
+
+    TEST_ASSERT_TRUE(tc.setAtomicSave(false));
+    TEST_ASSERT_FALSE(LittleFS.exists("/config.a"));
+    TEST_ASSERT_FALSE(LittleFS.exists("/config.b"));
+    TEST_ASSERT_EQUAL(4, tc.getInt("d", 0));
+    TEST_ASSERT_EQUAL(1, tc.getInt("a", 0));
+}
+
+void test_file_header() {
+    const char* check = "123456789";
+    TEST_ASSERT_EQUAL_UINT32(0xCBF43926, tinyConfigCrc32(reinterpret_cast<const uint8_t*>(check), 9));
+    TEST_ASSERT_EQUAL_UINT32(0xCBF43926, tinyConfigCrc32(reinterpret_cast<const uint8_t*>(check) + 4, 5,
+                                                         tinyConfigCrc32(reinterpret_cast<const uint8_t*>(check), 4)));
+
+    tc.resetConfig();
+    TEST_ASSERT_TRUE(tc.setFileHeader(true));
+    TEST_ASSERT_TRUE(tc.set("a", 1));
+    File f = LittleFS.open("/config.json", "r");
+    TEST_ASSERT_EQUAL('T', f.read());
+    TEST_ASSERT_EQUAL('C', f.read());
+    TEST_ASSERT_EQUAL(16 + strlen("{\"a\":1}"), f.size());
+    f.close();
+    TEST_ASSERT_EQUAL(1, tc.getInt("a", 0));
+    StringPrint out;
+    TEST_ASSERT_TRUE(tc.getAll(out));
+    TEST_ASSERT_EQUAL_STRING("{\"a\":1}", out.text.c_str());
+
+    // A corrupted file is detected by StartTC() before anything is parsed.
+    TEST_ASSERT_TRUE(tc.StopTC());
+    TEST_ASSERT_TRUE(LittleFS.begin());
+    f = LittleFS.open("/config.json", "r");
+    uint8_t content[32];
+    size_t length = f.read(content, sizeof(content));
+    f.close();
+    content[length - 2] = '2';
+    f = LittleFS.open("/config.json", "w");
+    f.write(content, length);
+    f.close();
+    TEST_ASSERT_FALSE(tc.StartTC());
+    TEST_ASSERT_EQUAL(TinyConfigError::ChecksumMismatch, tc.getLastError());
+#ifdef TINYCONFIG_HOST
+    // The failed start unmounted the filesystem again, so the next start is counted from zero.
+    TEST_ASSERT_FALSE(LittleFS.exists("/config.json"));
+#endif
+    // The header is checked whatever the setting, and in cache mode while the file is parsed.
+    TEST_ASSERT_TRUE(tc.setFileHeader(false));
+    TEST_ASSERT_FALSE(tc.StartTC());
+    TEST_ASSERT_EQUAL(TinyConfigError::ChecksumMismatch, tc.getLastError());
+    TEST_ASSERT_TRUE(tc.setCacheMode(true));
+    tc.resetStats();
+    TEST_ASSERT_FALSE(tc.StartTC());
+    TEST_ASSERT_EQUAL(TinyConfigError::ChecksumMismatch, tc.getLastError());
+    TEST_ASSERT_EQUAL(1, tc.getStats().loadCount);
+    TEST_ASSERT_TRUE(tc.setCacheMode(false));
+    TEST_ASSERT_TRUE(tc.setFileHeader(true));
+    TEST_ASSERT_TRUE(tc.resetConfig());
+    TEST_ASSERT_TRUE(tc.StartTC());
+    TEST_ASSERT_EQUAL(-1, tc.getInt("a", -1));
+
+    TEST_ASSERT_TRUE(tc.set("b", 2));
+    TEST_ASSERT_TRUE(tc.setFileHeader(false));
+    f = LittleFS.open("/config.json", "r");
+    TEST_ASSERT_EQUAL_STRING("{\"b\":2}", f.readString().c_str());
+    f.close();
+}
+
+void test_filtered_get() {
+    tc.resetConfig();
+    TinyConfig::Transaction tx = tc.beginTransaction();
+    for (int i = 0; i < 40; ++i) {
+        tx.set("key" + String(i), i);
+    }
+    String text;
+    for (int i = 0; i < 200; ++i) {
+        text += static_cast<char>('a' + i % 26);
+    }
+    tx.set("long", text);
+    TEST_ASSERT_TRUE(tx.commit());
+
+    // Only the requested member is parsed; a string gets a document sized from the file, so it needs one parse too.
+    tc.resetStats();
+#ifdef TINYCONFIG_HOST
+    size_t inUse = hostHeapStats().inUse;
+    hostHeapResetPeak();
+#endif
+    TEST_ASSERT_EQUAL(7, tc.getInt("key7", 0));
+    TEST_ASSERT_EQUAL(1, tc.getStats().loadCount);
+#ifdef TINYCONFIG_HOST
+    size_t filteredPeak = hostHeapStats().peak - inUse;
+    hostHeapResetPeak();
+#endif
+    TEST_ASSERT_EQUAL_STRING(text.c_str(), tc.getString("long", "").c_str());
+    TEST_ASSERT_EQUAL(2, tc.getStats().loadCount);
+    char buffer[256];
+    TEST_ASSERT_TRUE(tc.getString("long", buffer, sizeof(buffer), ""));
+    TEST_ASSERT_EQUAL_STRING(text.c_str(), buffer);
+    TEST_ASSERT_EQUAL(3, tc.getStats().loadCount);
+#ifdef TINYCONFIG_HOST
+    TEST_ASSERT_LESS_THAN(hostHeapStats().peak - inUse, filteredPeak);
+#endif
+    TEST_ASSERT_EQUAL(-1, tc.getInt(TC_KEY("missing"), -1));
+    TEST_ASSERT_EQUAL(TinyConfigError::None, tc.getLastError());
+}
+
+void test_namespaces() {
+    tc.resetConfig();
+    TEST_ASSERT_TRUE(tc.set("shared", 1));
+    TinyConfig wifi("wifi");
+    TinyConfig calib("calib");
+    TEST_ASSERT_TRUE(wifi.StartTC());
+    TEST_ASSERT_TRUE(calib.StartTC());
+    TEST_ASSERT_TRUE(wifi.set("ssid", String("home")));
+    TEST_ASSERT_TRUE(calib.set("gain", 1.5f));
+
+    // Each namespace only writes its own file.
+    File f = LittleFS.open("/wifi.json", "r");
+    TEST_ASSERT_EQUAL_STRING("{\"ssid\":\"home\"}", f.readString().c_str());
+    f.close();
+    TEST_ASSERT_EQUAL(-1, wifi.getInt("shared", -1));
+    TEST_ASSERT_EQUAL(1, tc.getInt("shared", 0));
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 1.5f, calib.getFloat("gain", 0.0f));
+
+    // Stopping one namespace leaves the filesystem mounted for the others.
+    TEST_ASSERT_TRUE(calib.StopTC());
+    TEST_ASSERT_EQUAL_STRING("home", wifi.getString("ssid", "").c_str());
+    TEST_ASSERT_TRUE(tc.set("shared", 2));
+    TEST_ASSERT_TRUE(wifi.StopTC());
+    TEST_ASSERT_EQUAL(2, tc.getInt("shared", 0));
+    LittleFS.remove("/wifi.json");
+    LittleFS.remove("/calib.json");
+}
+
+void test_on_change() {
+    tc.resetConfig();
+    int calls = 0;
+    int lastValue = 0;
+    bool lastNull = false;
+    tc.onChange("mode", [&](const char* key, JsonVariantConst value) {
+        TEST_ASSERT_EQUAL_STRING("mode", key);
+        calls++;
+        lastNull = value.isNull();
+        lastValue = value | -1;
+    });
+
+    TEST_ASSERT_TRUE(tc.set("mode", 3));
+    TEST_ASSERT_EQUAL(1, calls);
+    TEST_ASSERT_EQUAL(3, lastValue);
+    TEST_ASSERT_TRUE(tc.set("other", 4));
+    TEST_ASSERT_TRUE(tc.set(TC_KEY("mode"), 5));
+    TEST_ASSERT_EQUAL(2, calls);
+    TEST_ASSERT_EQUAL(5, lastValue);
+
+    // A rejected value does not notify.
+    tc.setMaxFileSize(20);
+    TEST_ASSERT_FALSE(tc.set("mode", String("much too long for the file")));
+    TEST_ASSERT_EQUAL(2, calls);
+    tc.setMaxFileSize(2048);
+
+    TEST_ASSERT_TRUE(tc.deleteKey("mode"));
+    TEST_ASSERT_EQUAL(3, calls);
+    TEST_ASSERT_TRUE(lastNull);
+
+    TinyConfig::Transaction tx = tc.beginTransaction();
+    tx.set("mode", 6);
+    tx.set("other", 7);
+    TEST_ASSERT_TRUE(tx.commit());
+    TEST_ASSERT_EQUAL(4, calls);
+    TEST_ASSERT_EQUAL(6, lastValue);
+
+    // Keys that keep their value are not notified.
+    TinyConfig::Transaction same = tc.beginTransaction();
+    same.set("mode", 6);
+    same.set("other", 8);
+    TEST_ASSERT_TRUE(same.commit());
+    TEST_ASSERT_EQUAL(4, calls);
+    TEST_ASSERT_TRUE(tc.set("mode", 6));
+    TEST_ASSERT_EQUAL(4, calls);
+
+    TEST_ASSERT_TRUE(tc.resetConfig());
+    TEST_ASSERT_EQUAL(5, calls);
+    TEST_ASSERT_TRUE(lastNull);
+
+    tc.removeOnChange("mode");
+    TEST_ASSERT_TRUE(tc.set("mode", 8));
+    TEST_ASSERT_EQUAL(5, calls);
+}
+
+void test_static_config() {
+    TinyConfigStatic<512> fixed("fixed");
+    TEST_ASSERT_TRUE(fixed.StartTC());
+    TEST_ASSERT_TRUE(fixed.resetConfig());
+    TEST_ASSERT_TRUE(fixed.set("count", 1));
+    TEST_ASSERT_TRUE(fixed.set(TC_KEY("name"), String("first")));
+    TEST_ASSERT_EQUAL(1, fixed.getInt("count", 0));
+
+    // Reads are served from the document inside the object; only the first TC_KEY() lookup allocates its table.
+    char name[16];
+    TEST_ASSERT_EQUAL(1, fixed.getInt(TC_KEY("count"), 0));
+#ifdef TINYCONFIG_HOST
+    size_t allocations = hostHeapStats().allocations;
+#endif
+    TEST_ASSERT_TRUE(fixed.getString(TC_KEY("name"), name, sizeof(name)));
+    TEST_ASSERT_EQUAL(1, fixed.getInt(TC_KEY("count"), 0));
+#ifdef TINYCONFIG_HOST
+    TEST_ASSERT_EQUAL(allocations, hostHeapStats().allocations);
+#endif
+    TEST_ASSERT_EQUAL_STRING("first", name);
+
+    // Replaced strings do not use up the document; a value that cannot fit is rejected.
+    String text;
+    for (int i = 0; i < 100; ++i) {
+        text += static_cast<char>('a' + i % 26);
+    }
+    for (int i = 0; i < 20; ++i) {
+        TEST_ASSERT_TRUE(fixed.set("text", text + String(i)));
+    }
+    TEST_ASSERT_EQUAL_STRING((text + "19").c_str(), fixed.getString("text", "").c_str());
+    TEST_ASSERT_FALSE(fixed.set("huge", text + text + text + text + text + text));
+    TEST_ASSERT_EQUAL(TinyConfigError::FileSizeTooLarge, fixed.getLastError());
+
+    // A merge that does not fit is rejected and keeps the uncommitted changes of write-back mode.
+    TEST_ASSERT_TRUE(fixed.setWriteBack(true));
+    TEST_ASSERT_TRUE(fixed.set("count", 2));
+    {
+        DynamicJsonDocument big(2048);
+        big["huge"] = text + text + text + text + text + text;
+        TEST_ASSERT_FALSE(fixed.merge(big.as<JsonObjectConst>()));
+        TEST_ASSERT_EQUAL(TinyConfigError::FileSizeTooLarge, fixed.getLastError());
+    }
+    TEST_ASSERT_TRUE(fixed.isDirty());
+    TEST_ASSERT_EQUAL(2, fixed.getInt("count", 0));
+    TEST_ASSERT_EQUAL(-1, fixed.getInt("huge", -1));
+    File f = LittleFS.open("/fixed.json", "r");
+    String content = f.readString();
+    f.close();
+    TEST_ASSERT_TRUE(content.indexOf("\"count\":1") >= 0);
+    TEST_ASSERT_TRUE(content.indexOf("huge") < 0);
+    TEST_ASSERT_TRUE(fixed.setWriteBack(false));
+
+    TEST_ASSERT_TRUE(fixed.StopTC());
+    TEST_ASSERT_TRUE(fixed.StartTC());
+    TEST_ASSERT_EQUAL(2, fixed.getInt("count", 0));
+    TEST_ASSERT_TRUE(fixed.StopTC());
+    LittleFS.remove("/fixed.json");
+}
+
+void test_flush_delay() {
+    tc.resetConfig();
+    TEST_ASSERT_TRUE(tc.setFlushDelay(50));
+    tc.resetStats();
+    for (int i = 0; i < 20; ++i) {
+        TEST_ASSERT_TRUE(tc.set("volume", i));
+        TEST_ASSERT_TRUE(tc.tick());
+    }
+    TEST_ASSERT_EQUAL(0, tc.getStats().flashWrites);
+    TEST_ASSERT_TRUE(tc.isDirty());
+    TEST_ASSERT_EQUAL(19, tc.getInt("volume", -1));
+
+    // The burst is written once after the quiet period.
+    delay(60);
+    TEST_ASSERT_TRUE(tc.tick());
+    TEST_ASSERT_EQUAL(1, tc.getStats().flashWrites);
+    TEST_ASSERT_FALSE(tc.isDirty());
+    TEST_ASSERT_TRUE(tc.tick());
+    TEST_ASSERT_EQUAL(1, tc.getStats().flashWrites);
+
+    TEST_ASSERT_TRUE(tc.set("volume", 3));
+    TEST_ASSERT_TRUE(tc.flushNow());
+    TEST_ASSERT_EQUAL(2, tc.getStats().flashWrites);
+    File f = LittleFS.open("/config.json", "r");
+    TEST_ASSERT_EQUAL_STRING("{\"volume\":3}", f.readString().c_str());
+    f.close();
+
+    TEST_ASSERT_TRUE(tc.setWriteBack(false));
+    TEST_ASSERT_TRUE(tc.set("volume", 4));
+    TEST_ASSERT_EQUAL(3, tc.getStats().flashWrites);
+}
+
+void test_config_ref() {
+    tc.resetConfig();
+    TinyConfigRef<float> gain = tc.ref<float>("gain", 1.0f);
+    TinyConfigRef<String> label = tc.ref<String>("label", "none");
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 1.0f, gain.get());
+    TEST_ASSERT_TRUE(gain.set(2.5f));
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 2.5f, gain.get());
+
+    // Repeated reads do not touch the file until the configuration changes.
+    tc.resetStats();
+    float sum = 0;
+    for (int i = 0; i < 100; ++i) {
+        sum += gain;
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.1, 250.0f, sum);
+    TEST_ASSERT_EQUAL(0, tc.getStats().loadCount);
+
+    // A rejected set() changes nothing, so the handles keep their values.
+    String huge;
+    for (int i = 0; i < 3000; ++i) {
+        huge += 'x';
+    }
+    TEST_ASSERT_FALSE(tc.set("huge", huge));
+    TEST_ASSERT_EQUAL(TinyConfigError::FileSizeTooLarge, tc.getLastError());
+    TEST_ASSERT_EQUAL(1, tc.getStats().loadCount);
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 2.5f, gain.get());
+    TEST_ASSERT_EQUAL(1, tc.getStats().loadCount);
+
+    TEST_ASSERT_TRUE(tc.set("label", String("main")));
+    TEST_ASSERT_EQUAL_STRING("main", label.get().c_str());
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 2.5f, gain.get());
+    TEST_ASSERT_TRUE(tc.deleteKey("gain"));
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 1.0f, gain.get());
+    TinyConfig::Transaction tx = tc.beginTransaction();
+    tx.set("gain", 4.0f);
+    TEST_ASSERT_TRUE(tx.commit());
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 4.0f, gain.get());
+    TEST_ASSERT_TRUE(tc.resetConfig());
+    TEST_ASSERT_EQUAL_STRING("none", label.get().c_str());
+}
+
+void test_set_many_and_merge() {
+    tc.resetConfig();
+    TEST_ASSERT_TRUE(tc.set("old", 1));
+    tc.resetStats();
+    TEST_ASSERT_TRUE(tc.setMany({{"ssid", "home"}, {"port", 80}, {"gain", 2.5f}, {"host", String("esp")}}));
+    TEST_ASSERT_EQUAL(1, tc.getStats().flashWrites);
+    TEST_ASSERT_EQUAL_STRING("home", tc.getString("ssid", "").c_str());
+    TEST_ASSERT_EQUAL(80, tc.getInt("port", 0));
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 2.5f, tc.getFloat("gain", 0.0f));
+    TEST_ASSERT_EQUAL_STRING("esp", tc.getString("host", "").c_str());
+    TEST_ASSERT_EQUAL(1, tc.getInt("old", 0));
+
+    // A form post: members replace existing keys, null deletes one.
+    {
+        StaticJsonDocument<256> form;
+        form["port"] = 8080;
+        form["ssid"] = String("office");
+        form["old"] = nullptr;
+        tc.resetStats();
+        TEST_ASSERT_TRUE(tc.merge(form.as<JsonObjectConst>()));
+        TEST_ASSERT_EQUAL(1, tc.getStats().flashWrites);
+    }
+    TEST_ASSERT_EQUAL(8080, tc.getInt("port", 0));
+    TEST_ASSERT_EQUAL_STRING("office", tc.getString("ssid", "").c_str());
+    TEST_ASSERT_EQUAL(-1, tc.getInt("old", -1));
+    TEST_ASSERT_EQUAL_STRING("esp", tc.getString("host", "").c_str());
+
+    // The size limit applies to the result; on failure nothing is written.
+    String text;
+    for (int i = 0; i < 100; ++i) {
+        text += 'x';
+    }
+    tc.setMaxFileSize(128);
+    tc.resetStats();
+    TEST_ASSERT_FALSE(tc.setMany({{"a", text}, {"b", text}}));
+    TEST_ASSERT_EQUAL(TinyConfigError::FileSizeTooLarge, tc.getLastError());
+    StaticJsonDocument<512> big;
+    big["a"] = text;
+    big["b"] = text;
+    TEST_ASSERT_FALSE(tc.merge(big.as<JsonObjectConst>()));
+    TEST_ASSERT_EQUAL(TinyConfigError::FileSizeTooLarge, tc.getLastError());
+    TEST_ASSERT_EQUAL(0, tc.getStats().flashWrites);
+    TEST_ASSERT_EQUAL(-1, tc.getInt("a", -1));
+    tc.setMaxFileSize(2048);
+
+    // Without StartTC() the transaction error is reported as is.
+    TinyConfig idle("idle");
+    TEST_ASSERT_FALSE(idle.setMany({{"port", 80}}));
+    TEST_ASSERT_EQUAL(TinyConfigError::FSNotRunning, idle.getLastError());
+}
+
+void test_get_many() {
+    tc.resetConfig();
+    TEST_ASSERT_TRUE(tc.setMany({{"port", 8080}, {"gain", 1.5f}, {"ssid", "home"}, {"host", "a_long_hostname"}}));
+
+    int port = 0;
+    int retries = 0;
+    float gain = 0.0f;
+    String ssid;
+    char host[8];
+    char missing[8];
+    tc.resetStats();
+    TEST_ASSERT_FALSE(tc.getMany({{"port", &port, 80},
+                                  {"retries", &retries, 3},
+                                  {"gain", &gain, 1.0f},
+                                  {"ssid", &ssid, "none"},
+                                  {"host", host, sizeof(host), "esp"},
+                                  {"missing", missing, sizeof(missing), "def"}}));
+    TEST_ASSERT_EQUAL(TinyConfigError::BufferTooSmall, tc.getLastError());
+    TEST_ASSERT_EQUAL(1, tc.getStats().loadCount);
+    TEST_ASSERT_EQUAL(8080, port);
+    TEST_ASSERT_EQUAL(3, retries);
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 1.5f, gain);
+    TEST_ASSERT_EQUAL_STRING("home", ssid.c_str());
+    TEST_ASSERT_EQUAL_STRING("a_long_", host);
+    TEST_ASSERT_EQUAL_STRING("def", missing);
+
+    std::vector<TinyConfigTarget> targets;
+    targets.push_back(TinyConfigTarget("port", &port));
+    TEST_ASSERT_TRUE(tc.getMany(targets.data(), targets.size()));
+    TEST_ASSERT_EQUAL(TinyConfigError::None, tc.getLastError());
+}
+
+const TinyConfigDefault testDefaults[] PROGMEM = {
+    {"port", 80},
+    {"retries", 3},
+    {"gain", 0.5f},
+    {"ssid", "tiny"},
+    {"host", nullptr},
+};
+
+void test_defaults() {
+    tc.resetConfig();
+    TinyConfigRef<int> retriesRef = tc.ref<int>("retries", -1);
+    TEST_ASSERT_EQUAL(-1, retriesRef.get());
+    tc.registerDefaults(testDefaults);
+    TEST_ASSERT_EQUAL(3, retriesRef.get());
+    TEST_ASSERT_TRUE(tc.set("port", 8080));
+
+    TEST_ASSERT_EQUAL(8080, tc.getInt("port", 1));
+    TEST_ASSERT_EQUAL(3, tc.getInt("retries", 1));
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 0.5f, tc.getFloat("gain", 0.0f));
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 3.0f, tc.getFloat("retries", 0.0f));
+    TEST_ASSERT_EQUAL_STRING("tiny", tc.getString("ssid", "none").c_str());
+    TEST_ASSERT_EQUAL(7, tc.getInt("ssid", 7));
+    TEST_ASSERT_EQUAL(9, tc.getInt("unknown", 9));
+    TEST_ASSERT_EQUAL(3, tc.ref<int>("retries", 0).get());
+
+    char ssid[8];
+    TEST_ASSERT_TRUE(tc.getString("ssid", ssid, sizeof(ssid), "none"));
+    TEST_ASSERT_EQUAL_STRING("tiny", ssid);
+    char tiny[3];
+    TEST_ASSERT_FALSE(tc.getString("ssid", tiny, sizeof(tiny), "none"));
+    TEST_ASSERT_EQUAL(TinyConfigError::BufferTooSmall, tc.getLastError());
+
+    // A text entry without text falls through to the fallback
+    TEST_ASSERT_EQUAL_STRING("none", tc.getString("host", "none").c_str());
+    char host[8];
+    TEST_ASSERT_TRUE(tc.getString("host", host, sizeof(host), "none"));
+    TEST_ASSERT_EQUAL_STRING("none", host);
+
+    int retries = 0;
+    String name;
+    char hostBuffer[8];
+    TEST_ASSERT_TRUE(tc.getMany({{"retries", &retries, 1}, {"ssid", &name, "none"}, {"host", hostBuffer, sizeof(hostBuffer), "esp"}}));
+    TEST_ASSERT_EQUAL(3, retries);
+    TEST_ASSERT_EQUAL_STRING("tiny", name.c_str());
+    TEST_ASSERT_EQUAL_STRING("esp", hostBuffer);
+
+    // Defaults are never written, and getAll() only merges them on request.
+    TEST_ASSERT_EQUAL_STRING("{\"port\":8080}", tc.getAll().c_str());
+    tc.setMergeDefaults(true);
+    DynamicJsonDocument all = tc.getAllJson();
+    TEST_ASSERT_EQUAL(8080, all["port"].as<int>());
+    TEST_ASSERT_EQUAL(3, all["retries"].as<int>());
+    TEST_ASSERT_EQUAL_STRING("tiny", all["ssid"]);
+    String merged = tc.getAll();
+    StringPrint out;
+    TEST_ASSERT_TRUE(tc.getAll(out));
+    TEST_ASSERT_EQUAL_STRING(merged.c_str(), out.text.c_str());
+    TEST_ASSERT_TRUE(merged.indexOf("\"retries\":3") >= 0);
+    tc.setMergeDefaults(false);
+
+    tc.setCacheMode(true);
+    TEST_ASSERT_EQUAL(3, tc.getInt("retries", 1));
+    TEST_ASSERT_TRUE(tc.deleteKey("port"));
+    TEST_ASSERT_EQUAL(80, tc.getInt("port", 1));
+    tc.setCacheMode(false);
+
+    tc.registerDefaults(nullptr, 0);
+    TEST_ASSERT_EQUAL(1, tc.getInt("retries", 1));
+}
+
+void test_indexed_format() {
+    tc.resetConfig();
+    TEST_ASSERT_TRUE(tc.setMaxFileSize(4096));
+    {
+        TinyConfig::Transaction tx = tc.beginTransaction();
+        for (int i = 0; i < 150; ++i) {
+            tx.set("key" + String(i), i);
+        }
+        tx.set("gain", 0.25f);
+        tx.set("name", String("sensor"));
+        TEST_ASSERT_TRUE(tx.commit());
+    }
+    TEST_ASSERT_TRUE(tc.setFormat(TinyConfigFormat::Indexed));
+    TEST_ASSERT_FALSE(LittleFS.exists("/config.json"));
+    File f = LittleFS.open("/config.idx", "r");
+    TEST_ASSERT_EQUAL(0xc1, f.read());
+    size_t fileSize = f.size();
+    f.close();
+
+    // A lookup reads a few index entries and the member, not the file
+    tc.resetStats();
+    TEST_ASSERT_EQUAL(42, tc.getInt("key42", 0));
+    TEST_ASSERT_EQUAL(1, tc.getStats().loadCount);
+    TEST_ASSERT_TRUE(tc.getStats().bytesParsed < 128);
+    TEST_ASSERT_EQUAL(7, tc.getInt("missing", 7));
+    TEST_ASSERT_EQUAL(149, tc.getInt(TC_KEY("key149"), 0));
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 0.25f, tc.getFloat("gain", 0.0f));
+    TEST_ASSERT_EQUAL_STRING("sensor", tc.getString("name", "").c_str());
+    char name[4];
+    TEST_ASSERT_FALSE(tc.getString("name", name, sizeof(name), ""));
+    TEST_ASSERT_EQUAL_STRING("sen", name);
+
+    // A successful lookup clears the error, so a ref reads the file only once
+    TinyConfigRef<int> ref = tc.ref<int>("key42", 0);
+    tc.resetStats();
+    for (int i = 0; i < 5; ++i) {
+        TEST_ASSERT_EQUAL(42, ref.get());
+    }
+    TEST_ASSERT_EQUAL(TinyConfigError::None, tc.getLastError());
+    TEST_ASSERT_EQUAL(1, tc.getStats().loadCount);
+
+    // An int or float of the same type is overwritten in place
+    tc.resetStats();
+    TEST_ASSERT_TRUE(tc.set("key42", 4242));
+    TEST_ASSERT_TRUE(tc.set("gain", 0.5f));
+    TEST_ASSERT_EQUAL(8, tc.getStats().bytesSerialized);
+    TEST_ASSERT_EQUAL(4242, tc.getInt("key42", 0));
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 0.5f, tc.getFloat("gain", 0.0f));
+    f = LittleFS.open("/config.idx", "r");
+    TEST_ASSERT_EQUAL(fileSize, f.size());
+    f.close();
+
+    // Other changes rewrite the file and keep the index sorted
+    TEST_ASSERT_TRUE(tc.set("key42", String("text")));
+    TEST_ASSERT_TRUE(tc.set("added", 1));
+    TEST_ASSERT_TRUE(tc.deleteKey("key7"));
+    TEST_ASSERT_EQUAL_STRING("text", tc.getString("key42", "").c_str());
+    TEST_ASSERT_EQUAL(1, tc.getInt("added", 0));
+    TEST_ASSERT_EQUAL(-1, tc.getInt("key7", -1));
+    TEST_ASSERT_EQUAL(150 + 2, tc.getAllJson().size());
+
+    tc.setCacheMode(true);
+    TEST_ASSERT_EQUAL(8, tc.getInt("key8", 0));
+    TEST_ASSERT_TRUE(tc.set("key8", 80));
+    tc.setCacheMode(false);
+    TEST_ASSERT_EQUAL(80, tc.getInt("key8", 0));
+
+    // Files with a header are parsed, so their CRC is checked
+    TEST_ASSERT_TRUE(tc.setFileHeader(true));
+    TEST_ASSERT_TRUE(tc.StopTC());
+    TEST_ASSERT_TRUE(tc.StartTC());
+    TEST_ASSERT_EQUAL(80, tc.getInt("key8", 0));
+    TEST_ASSERT_TRUE(tc.set("key8", 81));
+    TEST_ASSERT_EQUAL(81, tc.getInt("key8", 0));
+    TEST_ASSERT_TRUE(tc.setFileHeader(false));
+
+    TEST_ASSERT_TRUE(tc.setFormat(TinyConfigFormat::Json));
+    TEST_ASSERT_FALSE(LittleFS.exists("/config.idx"));
+    TEST_ASSERT_EQUAL(81, tc.getInt("key8", 0));
+    tc.resetConfig();
+    TEST_ASSERT_TRUE(tc.setMaxFileSize(2048));
+}
+
 void setup() {
     delay(2000);
     UNITY_BEGIN();
@@ -120,6 +1171,30 @@ void setup() {
     RUN_TEST(test_deleteKey);
     RUN_TEST(test_deleteKeys_array);
     RUN_TEST(test_deleteKeys_vector);
+    RUN_TEST(test_cache_mode);
+    RUN_TEST(test_write_back);
+    RUN_TEST(test_transaction);
+    RUN_TEST(test_transaction_rollback);
+    RUN_TEST(test_stats);
+    RUN_TEST(test_size_limit_cached);
+    RUN_TEST(test_log_mode);
+    RUN_TEST(test_msgpack_format);
+    RUN_TEST(test_schema);
+    RUN_TEST(test_key_handles);
+    RUN_TEST(test_buffer_getters);
+    RUN_TEST(test_getAll_stream);
+    RUN_TEST(test_atomic_save);
+    RUN_TEST(test_file_header);
+    RUN_TEST(test_filtered_get);
+    RUN_TEST(test_namespaces);
+    RUN_TEST(test_on_change);
+    RUN_TEST(test_static_config);
+    RUN_TEST(test_flush_delay);
+    RUN_TEST(test_config_ref);
+    RUN_TEST(test_set_many_and_merge);
+    RUN_TEST(test_get_many);
+    RUN_TEST(test_defaults);
+    RUN_TEST(test_indexed_format);
     RUN_TEST(test_max_file_size);
     RUN_TEST(test_stop_and_error);
     UNITY_END();